@@ -0,0 +1,100 @@
+#include "args.hpp"
+
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+/**
+ * @brief Runs fn in a child process and returns whether it exited with
+ * EXIT_FAILURE, since both parsers terminate on a missing value.
+ */
+template <typename Fn> static bool exits_with_failure(Fn fn) {
+  const pid_t pid = fork();
+  if (pid == 0) {
+    fn();
+    std::_Exit(EXIT_SUCCESS);
+  }
+  int status = 0;
+  waitpid(pid, &status, 0);
+  return WIFEXITED(status) && WEXITSTATUS(status) == EXIT_FAILURE;
+}
+
+int main(int argc, char **argv) {
+  (void)argc;
+  (void)argv;
+
+  std::string args[] = {"prog",   "a",   "--count",   "42",   "b",
+                        "--name", "bob", "--rate",    "2.5",  "--verbose",
+                        "true",   "c"};
+  std::vector<char *> v;
+  for (std::string &a : args)
+    v.push_back(a.data());
+
+  int count = 0;
+  std::string_view name;
+  double rate = 0;
+  bool verbose = false;
+  auto parser = make_arg_parser<"--count", "--name", "--rate", "--verbose">(
+      arg_value(count), arg_value(name), arg_value(rate), arg_value(verbose));
+  std::vector<std::string_view> unused;
+  for (std::string_view a : parser.process_args(v.size(), v.data()))
+    unused.push_back(a);
+
+  bool ok = count == 42 && name == "bob" && rate == 2.5 && verbose;
+  ok &= unused == std::vector<std::string_view>{"a", "b", "c"};
+  // argv is only permuted, so every argument is still there exactly once.
+  std::vector<std::string_view> sorted(v.begin(), v.end());
+  std::vector<std::string_view> expected(std::begin(args), std::end(args));
+  std::ranges::sort(sorted);
+  std::ranges::sort(expected);
+  ok &= sorted == expected;
+
+  std::cout << "Count: " << count << " Name: " << name << " Rate: " << rate
+            << " Unused: " << unused.size() << std::endl;
+
+  bool flag = true;
+  ok &= !arg_value(flag)("0") && !flag && !arg_value(flag)("1") && flag;
+  ok &= arg_value(flag)("yes") && arg_value(count)("12x");
+
+  arguments legacy;
+  int size = 0;
+  std::string_view file;
+  legacy.add_handler("--size", arg_value(size));
+  legacy.add_handler("--file", arg_value(file));
+  std::string legacy_args[] = {"prog", "x", "--size", "7", "y",
+                               "--file", "out.txt", "z"};
+  std::vector<char *> lv;
+  for (std::string &a : legacy_args)
+    lv.push_back(a.data());
+  const std::vector<std::string> legacy_unused =
+      legacy.process_args(lv.size(), lv.data());
+  ok &= size == 7 && file == "out.txt";
+  ok &= legacy_unused == std::vector<std::string>{"x", "y", "z"};
+
+  // A flag given as the last argument has no value and must not read past
+  // the end of argv.
+  std::string trailing[] = {"prog", "a", "--count"};
+  std::vector<char *> tv;
+  for (std::string &a : trailing)
+    tv.push_back(a.data());
+  tv.push_back(nullptr);
+  const bool parser_exits = exits_with_failure([&] {
+    for (std::string_view a : parser.process_args(tv.size() - 1, tv.data()))
+      (void)a;
+  });
+  const bool legacy_exits = exits_with_failure([&] {
+    trailing[2] = "--size";
+    tv[2] = trailing[2].data();
+    legacy.process_args(tv.size() - 1, tv.data());
+  });
+  ok &= parser_exits && legacy_exits;
+
+  std::cout << "Legacy unused: " << legacy_unused.size()
+            << " Trailing flag exits: " << (parser_exits && legacy_exits)
+            << " Ok: " << ok << std::endl;
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,105 @@
+#include "constexpr_map.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <string_view>
+
+enum class color { red = 3, green = -7, blue = 1000 };
+
+constexpr std::size_t key_count = 600;
+
+/**
+ * @brief Storage for the keys "k000" to "k599".
+ */
+constexpr auto key_chars = [] {
+  std::array<char, key_count * 4> s{};
+  for (std::size_t i = 0; i < key_count; i++) {
+    s[i * 4] = 'k';
+    s[i * 4 + 1] = char('0' + i / 100);
+    s[i * 4 + 2] = char('0' + i / 10 % 10);
+    s[i * 4 + 3] = char('0' + i % 10);
+  }
+  return s;
+}();
+
+constexpr std::string_view key(std::size_t i) {
+  return {key_chars.data() + i * 4, 4};
+}
+
+constexpr auto many_words = [] {
+  constexpr_map<std::string_view, std::size_t, key_count> m{};
+  for (std::size_t i = 0; i < key_count; i++)
+    m.data[i] = {key(i), i};
+  return m;
+}();
+
+constexpr auto many_numbers = [] {
+  constexpr_map<std::uint64_t, std::size_t, key_count> m{};
+  for (std::size_t i = 0; i < key_count; i++)
+    m.data[i] = {constexpr_mix(i), i};
+  return m;
+}();
+
+constexpr constexpr_map<std::string_view, int, 4> words{
+    {{{"alpha", 1}, {"beta", 2}, {"gamma", 3}, {"", 4}}}};
+constexpr constexpr_map<color, std::string_view, 3> colors{
+    {{{color::red, "red"}, {color::green, "green"}, {color::blue, "blue"}}}};
+constexpr constexpr_map<int, int, 0> nothing{};
+
+constexpr auto perfect_words = make_perfect_map(words);
+constexpr auto perfect_colors = make_perfect_map(colors);
+constexpr auto perfect_nothing = make_perfect_map(nothing);
+constexpr auto perfect_many_words = make_perfect_map(many_words);
+constexpr auto perfect_many_numbers = make_perfect_map(many_numbers);
+
+static_assert(perfect_words.at("gamma") == 3 && perfect_words.at("") == 4);
+static_assert(!perfect_words.contains("delta"));
+static_assert(perfect_colors.at(color::green) == "green");
+static_assert(!perfect_nothing.contains(0));
+static_assert(*words.find("beta") == 2 && !words.find("Beta"));
+
+int main(int argc, char **argv) {
+  (void)argc;
+  (void)argv;
+
+  bool ok = true;
+  for (const auto &[k, v] : words.data) {
+    ok &= perfect_words.find(k) && *perfect_words.find(k) == v;
+    ok &= words.find(k) && *words.find(k) == v;
+  }
+  for (const std::string_view miss : {"alph", "alphaa", "Beta", " ", "k000"})
+    ok &= !perfect_words.find(miss) && !words.find(miss);
+
+  for (const auto &[k, v] : colors.data)
+    ok &= perfect_colors.find(k) && *perfect_colors.find(k) == v;
+  ok &= !perfect_colors.find(static_cast<color>(4)) &&
+        !perfect_colors.find(static_cast<color>(0));
+
+  ok &= !perfect_nothing.find(0) && !nothing.find(0);
+
+  std::size_t hits = 0;
+  for (std::size_t i = 0; i < key_count; i++) {
+    const std::size_t *word = perfect_many_words.find(key(i));
+    const std::size_t *number = perfect_many_numbers.find(constexpr_mix(i));
+    ok &= word && *word == i && number && *number == i;
+    hits += word != nullptr;
+  }
+  for (const std::string_view miss : {"k600", "k999", "k00", "k0000", "x000"})
+    ok &= !perfect_many_words.find(miss);
+  for (std::size_t i = key_count; i < 10 * key_count; i++)
+    ok &= !perfect_many_numbers.find(constexpr_mix(i));
+  ok &= !perfect_many_numbers.find(0);
+
+  bool threw = false;
+  try {
+    (void)perfect_colors.at(static_cast<color>(4));
+  } catch (const std::range_error &) {
+    threw = true;
+  }
+  ok &= threw;
+
+  std::cout << "Hits: " << hits << " Ok: " << ok << std::endl;
+  return ok ? 0 : 1;
+}
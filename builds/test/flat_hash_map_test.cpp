@@ -0,0 +1,45 @@
+#include "flat_hash_map.hpp"
+
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+int main(int argc, char **argv) {
+  (void)argc;
+  (void)argv;
+
+  constexpr constexpr_map<std::string_view, int, 3> colors{
+      {{{"red", 0}, {"green", 1}, {"blue", 2}}}};
+  flat_hash_map<std::string_view, int> from_constexpr(colors);
+  std::cout << "green: " << *from_constexpr.find("green")
+            << " size: " << from_constexpr.size() << std::endl;
+
+  flat_hash_map<std::string, int> map;
+  for (int i = 0; i < 10000; i++)
+    map[std::to_string(i)] = i;
+  for (int i = 0; i < 10000; i += 2)
+    map.erase(std::to_string(i));
+  for (int i = 0; i < 1000; i++)
+    map.insert_or_assign(std::to_string(i), -i);
+
+  std::vector<std::string> keys;
+  for (int i = 0; i < 20000; i++)
+    keys.push_back(std::to_string(i));
+  std::vector<int *> found(keys.size());
+  std::size_t hits = map.find_many(keys, found);
+
+  bool ok = hits == map.size() && map.size() == 5500;
+  for (int i = 0; i < 20000; i++) {
+    const int expected = i < 1000 ? -i : i;
+    const bool present = i < 1000 || (i < 10000 && i % 2);
+    ok &= present ? found[i] && *found[i] == expected : !found[i];
+  }
+
+  flat_hash_map<std::string, int> copy = map;
+  ok &= copy.size() == map.size() && *copy.find("9999") == 9999;
+
+  std::cout << "Hits: " << hits << " Size: " << map.size()
+            << " Ok: " << ok << std::endl;
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,97 @@
+#include "unrolled_list.hpp"
+
+#include <iostream>
+#include <random>
+#include <span>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Compares every element, a random slice and its chunks to ref.
+ */
+static bool matches(unrolled_list<std::string, 8> &list,
+                    const std::vector<std::string> &ref, std::mt19937 &rng) {
+  bool ok = list.size() == ref.size();
+  for (std::size_t i = 0; ok && i < ref.size(); i++)
+    ok &= list[i] == ref[i];
+
+  const std::size_t start = rng() % (ref.size() + 1);
+  const std::size_t end = start + rng() % (ref.size() - start + 2);
+  const std::size_t last = std::min(end, ref.size());
+  auto slice = list.slice(start, end);
+  ok &= slice.size() == last - start;
+
+  std::size_t i = start;
+  for (const std::string &v : slice)
+    ok &= i < last && v == ref[i++];
+  ok &= i == last;
+
+  i = start;
+  slice.for_each_chunk([&](std::span<std::string> chunk) {
+    ok &= !chunk.empty() && chunk.size() <= 8;
+    for (const std::string &v : chunk)
+      ok &= i < last && v == ref[i++];
+  });
+  return ok && i == last;
+}
+
+int main(int argc, char **argv) {
+  (void)argc;
+  (void)argv;
+
+  std::mt19937 rng(7);
+  unrolled_list<std::string, 8> list;
+  std::vector<std::string> ref;
+  bool ok = true;
+
+  // Alternate growing and shrinking phases, so erases empty and merge chunks
+  // anywhere, including into the tail chunk, down to an empty list.
+  for (int phase = 0; phase < 8; phase++) {
+    const bool grow = phase % 2 == 0;
+    for (int step = 0; step < 3000; step++) {
+      const unsigned op = rng() % 4;
+      if (ref.empty() || (grow ? op != 0 : op == 0)) {
+        const std::size_t pos = rng() % (ref.size() + 1);
+        const std::string v = std::to_string(phase * 10000 + step);
+        if (op == 3) {
+          list.push_back(v);
+          ref.push_back(v);
+        } else {
+          list.insert(pos, v);
+          ref.insert(ref.begin() + pos, v);
+        }
+      } else {
+        const std::size_t pos =
+            op == 1 ? ref.size() - 1 : rng() % ref.size();
+        list.erase(pos);
+        ref.erase(ref.begin() + pos);
+      }
+      if (step % 31 == 0 || ref.size() < 20)
+        ok &= matches(list, ref, rng);
+    }
+    ok &= matches(list, ref, rng);
+  }
+
+  // Small lists where erasing the front merges into the last chunk.
+  for (std::size_t n = 1; n < 40 && ok; n++) {
+    unrolled_list<std::string, 8> small;
+    std::vector<std::string> small_ref;
+    for (std::size_t i = 0; i < n; i++) {
+      small.push_back(std::to_string(i));
+      small_ref.push_back(std::to_string(i));
+    }
+    while (!small_ref.empty()) {
+      small.erase(0);
+      small_ref.erase(small_ref.begin());
+      ok &= matches(small, small_ref, rng);
+    }
+  }
+
+  unrolled_list<std::string, 8> copy = list;
+  ok &= matches(copy, ref, rng);
+  list.clear();
+  ok &= list.size() == 0 && list.begin() == list.end();
+
+  std::cout << "Size: " << copy.size() << " Ok: " << ok << std::endl;
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,91 @@
+#include "utils.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <list>
+#include <random>
+#include <span>
+#include <vector>
+
+/**
+ * @brief The element-wise definition the vectorized error() must match.
+ */
+template <typename T>
+T reference_error(const std::vector<T> &estimated,
+                  const std::vector<T> &actual) {
+  T max_error = std::numeric_limits<T>::lowest();
+  const std::size_t n = std::min(estimated.size(), actual.size());
+  for (std::size_t i = 0; i < n; i++)
+    max_error = std::max(max_error, error(estimated[i], actual[i]));
+  return max_error;
+}
+
+template <typename T> static bool same(T a, T b) {
+  return a == b || (std::isnan(a) && std::isnan(b));
+}
+
+template <typename T> bool check_error() {
+  constexpr T inf = std::numeric_limits<T>::infinity();
+  constexpr T nan = std::numeric_limits<T>::quiet_NaN();
+  std::mt19937 rng(42);
+  std::uniform_real_distribution<T> dist(-5, 5);
+
+  bool ok = true;
+  // The last three pairs make the result infinite, so they are only mixed in
+  // on a second pass.
+  const T specials[][2] = {{T(2), T(-0.0)}, {T(-3), T(0)}, {nan, T(1)},
+                           {T(1), nan},     {T(2), inf},   {inf, T(2)},
+                           {inf, T(0)},     {-inf, T(-0.0)}};
+  for (const std::size_t n : {0, 1, 7, 33, 1000, 1 << 20}) {
+    for (const std::size_t used : {5, 8}) {
+      // actual is longer, so only the first n elements may count.
+      std::vector<T> estimated(n), actual(n + 5, T(1e30));
+      for (std::size_t i = 0; i < n; i++) {
+        estimated[i] = dist(rng);
+        actual[i] = i % 17 == 0 ? T(0) : dist(rng);
+      }
+      for (std::size_t s = 0; s < used && s * 5 < n; s++) {
+        estimated[s * 5] = specials[s][0];
+        actual[s * 5] = specials[s][1];
+      }
+
+      const T expected = reference_error(estimated, actual);
+      const std::list<T> estimated_list(estimated.begin(), estimated.end());
+      const std::list<T> actual_list(actual.begin(), actual.end());
+      ok &= same(expected, error(estimated, actual));
+      ok &= same(expected, error(estimated_list, actual_list));
+      ok &= same(expected, error(estimated, actual, 0));
+      ok &= same(expected, error(estimated, actual, 3));
+      ok &= same(reference_error(actual, estimated), error(actual, estimated));
+    }
+  }
+  return ok;
+}
+
+int main(int argc, char **argv) {
+  (void)argc;
+  (void)argv;
+
+  const bool floats = check_error<float>();
+  const bool doubles = check_error<double>();
+  std::cout << "Error float: " << floats << " double: " << doubles
+            << std::endl;
+
+  const std::vector<int> a{1, 2, 3}, b{1, 2, 3}, c{1, 2, 4}, d{1, 2};
+  const std::vector<double> zero{0.0, 1.0}, negative_zero{-0.0, 1.0};
+  const std::vector<double> nan{std::nan(""), 1.0};
+  using ints = std::span<const int>;
+  using doubles_span = std::span<const double>;
+  // Spans select the range operator== rather than std::vector's.
+  const bool equality =
+      ints(a) == ints(b) && !(ints(a) == ints(c)) && !(ints(a) == ints(d)) &&
+      ints() == ints() && doubles_span(zero) == doubles_span(negative_zero) &&
+      !(doubles_span(nan) == doubles_span(nan));
+  std::cout << "Equality: " << equality << std::endl;
+
+  const bool ok = floats && doubles && equality;
+  std::cout << "Ok: " << ok << std::endl;
+  return ok ? 0 : 1;
+}
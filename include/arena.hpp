@@ -0,0 +1,303 @@
+#ifndef EXSTD_ARENA_HPP
+#define EXSTD_ARENA_HPP
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <mutex>
+
+#include "singleton.hpp"
+
+/**
+ * @file arena.hpp
+ * @brief Definition of the arena and pool memory resources.
+ */
+
+/**
+ * @brief A bump allocator handing out memory from large chunks.
+ *
+ * Deallocation is a no-op; memory is reclaimed all at once by reset(), which
+ * keeps the chunks so the next round of allocations does not go upstream
+ * again, or by release(), which returns them. Not thread-safe.
+ */
+class monotonic_arena : public std::pmr::memory_resource {
+public:
+  /**
+   * @brief Constructor.
+   * @param chunk_size The minimum size of the chunks taken from upstream.
+   * @param upstream The resource the chunks are allocated from.
+   */
+  explicit monotonic_arena(
+      std::size_t chunk_size = 64 * 1024,
+      std::pmr::memory_resource *upstream = std::pmr::new_delete_resource())
+      : chunk_size(chunk_size), upstream(upstream) {}
+
+  monotonic_arena(const monotonic_arena &) = delete;
+  monotonic_arena &operator=(const monotonic_arena &) = delete;
+
+  /**
+   * @brief Destructor. Returns all chunks upstream.
+   */
+  ~monotonic_arena() override { release(); }
+
+  /**
+   * @brief Rewind to the first chunk, keeping all chunks for reuse.
+   *
+   * Everything allocated from the arena is invalidated.
+   */
+  void reset() noexcept {
+    current = head;
+    if (current)
+      rewind(current);
+  }
+
+  /**
+   * @brief Return all chunks upstream.
+   *
+   * Everything allocated from the arena is invalidated.
+   */
+  void release() noexcept {
+    while (head) {
+      chunk *next = head->next;
+      upstream->deallocate(head, head->size, alignof(chunk));
+      head = next;
+    }
+    current = nullptr;
+    ptr = end = nullptr;
+  }
+
+protected:
+  void *do_allocate(std::size_t bytes, std::size_t alignment) override {
+    for (;;) {
+      if (current) {
+        const auto p = reinterpret_cast<std::uintptr_t>(ptr);
+        const std::uintptr_t aligned = (p + alignment - 1) & ~(alignment - 1);
+        if (aligned + bytes <= reinterpret_cast<std::uintptr_t>(end)) {
+          ptr = reinterpret_cast<std::byte *>(aligned + bytes);
+          return reinterpret_cast<void *>(aligned);
+        }
+        if (current->next) {
+          // Chunks kept by reset() that are too small are skipped until the
+          // next reset.
+          current = current->next;
+          rewind(current);
+          continue;
+        }
+      }
+      add_chunk(bytes + alignment);
+    }
+  }
+
+  void do_deallocate(void *, std::size_t, std::size_t) override {}
+
+  bool do_is_equal(
+      const std::pmr::memory_resource &other) const noexcept override {
+    return this == &other;
+  }
+
+private:
+  /**
+   * @brief Header at the start of every chunk, followed by its memory.
+   */
+  struct alignas(std::max_align_t) chunk {
+    chunk *next;
+    std::size_t size; ///< Size of the chunk, header included.
+  };
+
+  void rewind(chunk *c) noexcept {
+    ptr = reinterpret_cast<std::byte *>(c + 1);
+    end = reinterpret_cast<std::byte *>(c) + c->size;
+  }
+
+  void add_chunk(std::size_t min_bytes) {
+    const std::size_t size = std::max(chunk_size, min_bytes + sizeof(chunk));
+    chunk *c = static_cast<chunk *>(upstream->allocate(size, alignof(chunk)));
+    c->next = nullptr;
+    c->size = size;
+    if (current)
+      current->next = c;
+    else
+      head = c;
+    current = c;
+    rewind(c);
+  }
+
+  std::size_t chunk_size;               ///< Minimum chunk size.
+  std::pmr::memory_resource *upstream; ///< Source of the chunks.
+  chunk *head = nullptr;                ///< First chunk.
+  chunk *current = nullptr;             ///< Chunk being allocated from.
+  std::byte *ptr = nullptr;             ///< Next free byte in current.
+  std::byte *end = nullptr;             ///< End of current.
+};
+
+/**
+ * @brief A process-wide pool of fixed-size blocks with per-thread caches.
+ *
+ * Requests up to max_block bytes are rounded up to a power-of-two size class
+ * and served from a free list of the calling thread, without locking. A
+ * thread whose cache for a class grows too large (e.g. the consumer side of a
+ * queue) moves half of it to a shared depot, from which threads that run out
+ * (the producer side) refill in batches; only those transfers lock. Blocks
+ * are carved from a monotonic_arena and never returned to the system, so
+ * once the pool has warmed up, steady-state allocation makes no calls to the
+ * global allocator. Larger or over-aligned requests go to
+ * std::pmr::new_delete_resource(). Threads whose cache has already been
+ * released (thread_local destructors running at exit) use the depot directly.
+ *
+ * All instances share the same pool and compare equal.
+ */
+class pool_resource : public std::pmr::memory_resource {
+public:
+  static constexpr std::size_t min_block = 16;
+  static constexpr std::size_t max_block = 4096;
+  static constexpr std::size_t classes =
+      std::countr_zero(max_block) - std::countr_zero(min_block) + 1;
+
+  /**
+   * @brief Access the shared pool.
+   *
+   * @return A reference to a pool_resource.
+   */
+  static pool_resource &instance() {
+    static pool_resource pool;
+    return pool;
+  }
+
+protected:
+  void *do_allocate(std::size_t bytes, std::size_t alignment) override {
+    if (bytes > max_block || alignment > alignof(std::max_align_t))
+      return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+
+    const std::size_t c = size_class(bytes);
+    cache *local = thread_singleton<cache>::try_instance();
+    if (!local) [[unlikely]]
+      return take_shared(c);
+    if (!local->head[c])
+      refill(*local, c);
+    block *b = local->head[c];
+    local->head[c] = b->next;
+    local->count[c]--;
+    return b;
+  }
+
+  void do_deallocate(void *p, std::size_t bytes,
+                     std::size_t alignment) override {
+    if (bytes > max_block || alignment > alignof(std::max_align_t)) {
+      std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+      return;
+    }
+
+    const std::size_t c = size_class(bytes);
+    block *b = static_cast<block *>(p);
+    cache *local = thread_singleton<cache>::try_instance();
+    if (!local) [[unlikely]] {
+      give_shared(b, c);
+      return;
+    }
+    b->next = local->head[c];
+    local->head[c] = b;
+    if (++local->count[c] > cache_limit(c))
+      spill(*local, c);
+  }
+
+  bool do_is_equal(
+      const std::pmr::memory_resource &other) const noexcept override {
+    return dynamic_cast<const pool_resource *>(&other) != nullptr;
+  }
+
+private:
+  struct block {
+    block *next;
+  };
+
+  struct cache {
+    std::array<block *, classes> head{};
+    std::array<std::size_t, classes> count{};
+  };
+
+  struct depot {
+    std::mutex mutex;
+    std::array<block *, classes> head{};
+    std::array<std::size_t, classes> count{};
+    monotonic_arena arena{256 * 1024};
+  };
+
+  static std::size_t size_class(std::size_t bytes) noexcept {
+    return std::countr_zero(std::bit_ceil(std::max(bytes, min_block))) -
+           std::countr_zero(min_block);
+  }
+
+  static std::size_t block_size(std::size_t c) noexcept {
+    return min_block << c;
+  }
+
+  /**
+   * @brief Number of blocks a thread keeps for a class, about 64 KiB.
+   */
+  static std::size_t cache_limit(std::size_t c) noexcept {
+    return std::max<std::size_t>(16, 64 * 1024 / block_size(c));
+  }
+
+  static depot &shared() {
+    // Never destroyed: blocks may be freed by static destructors.
+    static depot *d = new depot;
+    return *d;
+  }
+
+  static void refill(cache &local, std::size_t c) {
+    const std::size_t batch = cache_limit(c) / 2;
+    depot &d = shared();
+    std::lock_guard<std::mutex> lock(d.mutex);
+    for (std::size_t i = 0; i < batch; i++) {
+      block *b = d.head[c];
+      if (b) {
+        d.head[c] = b->next;
+        d.count[c]--;
+      } else {
+        b = static_cast<block *>(
+            d.arena.allocate(block_size(c), alignof(std::max_align_t)));
+      }
+      b->next = local.head[c];
+      local.head[c] = b;
+    }
+    local.count[c] += batch;
+  }
+
+  static void *take_shared(std::size_t c) {
+    depot &d = shared();
+    std::lock_guard<std::mutex> lock(d.mutex);
+    block *b = d.head[c];
+    if (!b)
+      return d.arena.allocate(block_size(c), alignof(std::max_align_t));
+    d.head[c] = b->next;
+    d.count[c]--;
+    return b;
+  }
+
+  static void give_shared(block *b, std::size_t c) {
+    depot &d = shared();
+    std::lock_guard<std::mutex> lock(d.mutex);
+    b->next = d.head[c];
+    d.head[c] = b;
+    d.count[c]++;
+  }
+
+  static void spill(cache &local, std::size_t c) {
+    const std::size_t batch = local.count[c] / 2;
+    depot &d = shared();
+    std::lock_guard<std::mutex> lock(d.mutex);
+    for (std::size_t i = 0; i < batch; i++) {
+      block *b = local.head[c];
+      local.head[c] = b->next;
+      b->next = d.head[c];
+      d.head[c] = b;
+    }
+    local.count[c] -= batch;
+    d.count[c] += batch;
+  }
+};
+
+#endif
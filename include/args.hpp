@@ -6,13 +6,24 @@
 #ifndef ARGS_HPP
 #define ARGS_HPP
 
+#include <algorithm>
+#include <charconv>
 #include <cstdlib>
 #include <functional>
+#include <iostream>
+#include <ranges>
+#include <span>
 #include <string>
 #include <string_view>
+#include <system_error>
+#include <tuple>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
+#include "constexpr_map.hpp"
+#include "flat_hash_map.hpp"
+
 /**
  * @brief Struct to manage and process command-line arguments.
  */
@@ -66,26 +77,27 @@ void arguments::add_handler(
  * @return A vector of strings containing unused arguments.
  */
 std::vector<std::string> arguments::process_args(int argc, char **argv) {
-  std::vector<std::string_view> args(argv + 1, argv + argc);
-  for (auto &str_func : action) {
-    auto arg_it = std::begin(args);
-    while (arg_it != std::end(args)) {
-      if (*arg_it == str_func.first) {
-        const std::string_view next = *std::next(arg_it);
-        if (str_func.second(next)) {
-          std::exit(EXIT_FAILURE);
-        }
-        // Remove arg_it and next from args
-        arg_it = args.erase(arg_it, std::next(arg_it, 2));
-      } else {
-        arg_it = std::next(arg_it);
-      }
-    }
-  }
+  // First registration wins when a flag is registered twice.
+  flat_hash_map<std::string_view, std::size_t> index;
+  index.reserve(action.size());
+  for (std::size_t i = 0; i < action.size(); i++)
+    index.try_emplace(action[i].first, i);
 
   std::vector<std::string> unused;
-  for (auto left : args)
-    unused.push_back(left.data());
+  for (int i = 1; i < argc; i++) {
+    const std::size_t *handler = index.find(argv[i]);
+    if (!handler) {
+      unused.emplace_back(argv[i]);
+      continue;
+    }
+    // A flag given as the last argument has no value to pass on.
+    if (i + 1 == argc) {
+      std::cerr << "Missing value for argument " << argv[i] << std::endl;
+      std::exit(EXIT_FAILURE);
+    }
+    if (action[*handler].second(argv[++i]))
+      std::exit(EXIT_FAILURE);
+  }
   return unused;
 }
 
@@ -94,4 +106,138 @@ std::vector<std::string> arguments::process_args(int argc, char **argv) {
  */
 arguments::arguments() {}
 
+/**
+ * @brief A command-line flag name usable as a template argument.
+ *
+ * @tparam n The size of the string literal, including the terminator.
+ */
+template <std::size_t n> struct flag_name {
+  char str[n];
+
+  consteval flag_name(const char (&s)[n]) { std::copy_n(s, n, str); }
+
+  constexpr std::string_view view() const { return {str, n - 1}; }
+};
+
+/**
+ * @brief Makes a handler that parses a flag value into a variable.
+ *
+ * Arithmetic types are parsed with std::from_chars directly from the argument,
+ * bool accepts "true", "false", "1" and "0", anything else is assigned from
+ * the std::string_view.
+ *
+ * @tparam T The type of the variable.
+ * @param out The variable to store the parsed value in.
+ * @return A handler returning true when the value could not be parsed.
+ */
+template <typename T> constexpr auto arg_value(T &out) {
+  return [&out](std::string_view v) -> bool {
+    if constexpr (std::is_same_v<T, bool>) {
+      if (v == "true" || v == "1")
+        out = true;
+      else if (v == "false" || v == "0")
+        out = false;
+      else
+        return true;
+      return false;
+    } else if constexpr (std::is_arithmetic_v<T>) {
+      const char *end = v.data() + v.size();
+      const auto [ptr, ec] = std::from_chars(v.data(), end, out);
+      return ec != std::errc() || ptr != end;
+    } else {
+      out = v;
+      return false;
+    }
+  };
+}
+
+/**
+ * @brief A single-pass command-line parser with compile-time flag lookup.
+ *
+ * The flags are hashed into a perfect_map at compile time and each handler
+ * keeps its own type, so an argument costs one hash lookup and a direct call.
+ * Handlers have the same contract as for arguments: they receive the value
+ * following the flag, and returning true terminates the program.
+ *
+ * @tparam handlers A std::tuple of the handler types.
+ * @tparam flags The flag names, in the same order as the handlers.
+ */
+template <typename handlers, flag_name... flags> struct arg_parser {
+  handlers action;
+
+  /**
+   * @brief Processes the command-line arguments.
+   *
+   * Unused arguments are swapped to the front of argv in their original order,
+   * so no memory is allocated and argv stays a permutation of its elements.
+   *
+   * @param argc Argument count.
+   * @param argv Argument vector, permuted in place.
+   * @return A view of std::string_view over the unused arguments.
+   */
+  auto process_args(int argc, char **argv) {
+    char **unused = argv + 1;
+    for (int i = 1; i < argc; i++) {
+      const std::string_view arg = argv[i];
+      const std::size_t *handler = table.find(arg);
+      if (!handler) {
+        std::swap(*unused++, argv[i]);
+        continue;
+      }
+      if (i + 1 == argc) {
+        std::cerr << "Missing value for argument " << arg << std::endl;
+        std::exit(EXIT_FAILURE);
+      }
+      if (dispatch(*handler, argv[++i],
+                   std::make_index_sequence<sizeof...(flags)>{}))
+        std::exit(EXIT_FAILURE);
+    }
+
+    return std::span<char *>(argv + 1, unused) |
+           std::views::transform(
+               [](const char *a) { return std::string_view(a); });
+  }
+
+private:
+  template <std::size_t... I>
+  static consteval auto build_table(std::index_sequence<I...>) {
+    return make_perfect_map(
+        constexpr_map<std::string_view, std::size_t, sizeof...(flags)>{
+            {{std::pair<std::string_view, std::size_t>{flags.view(), I}...}}});
+  }
+
+  static constexpr auto table =
+      build_table(std::make_index_sequence<sizeof...(flags)>{});
+
+  template <std::size_t... I>
+  bool dispatch(std::size_t handler, std::string_view value,
+                std::index_sequence<I...>) {
+    bool failed = false;
+    ((handler == I && (failed = std::get<I>(action)(value), true)) || ...);
+    return failed;
+  }
+};
+
+/**
+ * @brief Builds an arg_parser for the given flags.
+ *
+ * @code
+ * int count = 0;
+ * std::string_view name;
+ * auto parser = make_arg_parser<"--count", "--name">(arg_value(count),
+ *                                                     arg_value(name));
+ * for (std::string_view arg : parser.process_args(argc, argv))
+ *   ...
+ * @endcode
+ *
+ * @tparam flags The flag names.
+ * @param h One handler per flag, in the same order.
+ * @return The parser.
+ */
+template <flag_name... flags, typename... Handlers>
+  requires(sizeof...(flags) == sizeof...(Handlers))
+constexpr auto make_arg_parser(Handlers... h) {
+  return arg_parser<std::tuple<Handlers...>, flags...>{{std::move(h)...}};
+}
+
 #endif // ARGS_HPP
@@ -3,7 +3,11 @@
 
 #include <algorithm>
 #include <array>
+#include <concepts>
+#include <cstdint>
 #include <stdexcept>
+#include <string_view>
+#include <type_traits>
 #include <utility>
 
 /**
@@ -37,13 +41,245 @@ template <typename key, typename value, std::size_t size> struct constexpr_map {
    * @throws std::range_error if the key is not found in the map.
    */
   [[nodiscard]] constexpr value at(const key &k) const {
+    if (const value *v = find(k))
+      return *v;
+    else
+      throw std::range_error("value not found for key");
+  }
+
+  /**
+   * @brief Find the value associated with a key without throwing.
+   *
+   * @param k The key to look up.
+   * @return A pointer to the value, or nullptr if the key is not in the map.
+   */
+  [[nodiscard]] constexpr const value *find(const key &k) const noexcept {
     const auto it = std::find_if(begin(data), end(data),
                                  [&k](const auto &v) { return v.first == k; });
-    if (it != end(data))
-      return it->second;
+    return it != end(data) ? &it->second : nullptr;
+  }
+};
+
+/**
+ * @brief Finalizer used to spread hash bits (splitmix64).
+ *
+ * @param x The value to mix.
+ * @return The mixed value.
+ */
+constexpr std::uint64_t constexpr_mix(std::uint64_t x) noexcept {
+  x += 0x9e3779b97f4a7c15ull;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+  return x ^ (x >> 31);
+}
+
+/**
+ * @brief Hash usable both at compile time and at runtime.
+ *
+ * Specialized for integral types, enums and anything convertible to
+ * std::string_view. Specialize it for other key types used with
+ * perfect_map.
+ *
+ * @tparam key The type to hash.
+ */
+template <typename key> struct constexpr_hash;
+
+template <typename key>
+  requires std::is_integral_v<key> || std::is_enum_v<key>
+struct constexpr_hash<key> {
+  constexpr std::uint64_t operator()(const key &k) const noexcept {
+    if constexpr (std::is_enum_v<key>)
+      return constexpr_mix(static_cast<std::uint64_t>(
+          static_cast<std::underlying_type_t<key>>(k)));
+    else
+      return constexpr_mix(static_cast<std::uint64_t>(k));
+  }
+};
+
+template <typename key>
+  requires std::convertible_to<const key &, std::string_view>
+struct constexpr_hash<key> {
+  constexpr std::uint64_t operator()(const key &k) const noexcept {
+    // FNV-1a, then mixed so the low bits are usable for modulo.
+    const std::string_view s = k;
+    std::uint64_t h = 0xcbf29ce484222325ull;
+    for (const char c : s) {
+      h ^= static_cast<unsigned char>(c);
+      h *= 0x100000001b3ull;
+    }
+    return constexpr_mix(h);
+  }
+};
+
+/**
+ * @brief A constexpr map with a compile-time perfect hash.
+ *
+ * The `perfect_map` holds the same entries as a `constexpr_map`, reordered so
+ * that a minimal perfect hash (CHD style: one displacement seed per bucket)
+ * maps every key to its own slot. A lookup hashes the key once, reads one
+ * seed and does a single key comparison. Build it with make_perfect_map().
+ *
+ * @tparam key The type of keys in the map.
+ * @tparam value The type of values associated with the keys.
+ * @tparam size The fixed size of the map.
+ * @tparam hash The hash functor, see constexpr_hash.
+ */
+template <typename key, typename value, std::size_t size,
+          typename hash = constexpr_hash<key>>
+struct perfect_map {
+  std::array<std::pair<key, value>, size> data;
+  std::array<std::uint32_t, size> seeds;
+
+  /**
+   * @brief Slot of a key for a given bucket seed.
+   *
+   * @param h The hash of the key.
+   * @param seed The seed of the bucket the key belongs to.
+   * @return The slot index in data.
+   */
+  static constexpr std::size_t slot(std::uint64_t h,
+                                    std::uint32_t seed) noexcept {
+    return constexpr_mix(h + seed * 0x9e3779b97f4a7c15ull) % size;
+  }
+
+  /**
+   * @brief Find the value associated with a key without throwing.
+   *
+   * @param k The key to look up.
+   * @return A pointer to the value, or nullptr if the key is not in the map.
+   */
+  [[nodiscard]] constexpr const value *find(const key &k) const noexcept {
+    if constexpr (size == 0) {
+      return nullptr;
+    } else {
+      const std::uint64_t h = hash{}(k);
+      const auto &entry = data[slot(h, seeds[h % size])];
+      return entry.first == k ? &entry.second : nullptr;
+    }
+  }
+
+  /**
+   * @brief Check whether a key is in the map.
+   *
+   * @param k The key to look up.
+   * @return True if the key is present, false otherwise.
+   */
+  [[nodiscard]] constexpr bool contains(const key &k) const noexcept {
+    return find(k) != nullptr;
+  }
+
+  /**
+   * @brief Get the value associated with a key.
+   *
+   * @param k The key for which to retrieve the value.
+   * @return The value associated with the key.
+   * @throws std::range_error if the key is not found in the map.
+   */
+  [[nodiscard]] constexpr value at(const key &k) const {
+    if (const value *v = find(k))
+      return *v;
     else
       throw std::range_error("value not found for key");
   }
 };
 
+namespace detail {
+
+/**
+ * @brief Computes the bucket seeds and the slot of every key.
+ *
+ * Buckets are placed largest first; for each one the smallest seed that sends
+ * all of its keys to free, distinct slots is kept. Failing to find one (which
+ * only happens with duplicate keys or full hash collisions) is a compile error
+ * when called from make_perfect_map().
+ */
+template <typename key, typename value, std::size_t size, typename hash>
+consteval auto build_perfect_hash(const constexpr_map<key, value, size> &m) {
+  using map_type = perfect_map<key, value, size, hash>;
+  constexpr std::size_t none = size;
+
+  std::array<std::uint64_t, size> hashes{};
+  for (std::size_t i = 0; i < size; i++)
+    hashes[i] = hash{}(m.data[i].first);
+
+  // Counting sort of the keys by bucket.
+  std::array<std::size_t, size + 1> bucket_start{};
+  for (std::size_t i = 0; i < size; i++)
+    bucket_start[hashes[i] % size + 1]++;
+  std::size_t max_bucket = 0;
+  for (std::size_t b = 0; b < size; b++) {
+    max_bucket = std::max(max_bucket, bucket_start[b + 1]);
+    bucket_start[b + 1] += bucket_start[b];
+  }
+  std::array<std::size_t, size> members{};
+  std::array<std::size_t, size> fill{};
+  for (std::size_t i = 0; i < size; i++) {
+    const std::size_t b = hashes[i] % size;
+    members[bucket_start[b] + fill[b]++] = i;
+  }
+
+  std::array<std::uint32_t, size> seeds{};
+  std::array<std::size_t, size> order{}; // slot -> index in m.data
+  order.fill(none);
+  std::array<std::size_t, size> trial{};
+
+  for (std::size_t len = max_bucket; len > 0; len--) {
+    for (std::size_t b = 0; b < size; b++) {
+      if (bucket_start[b + 1] - bucket_start[b] != len)
+        continue;
+
+      const std::size_t *keys = members.data() + bucket_start[b];
+      for (std::size_t i = 0; i < len; i++)
+        for (std::size_t j = 0; j < i; j++)
+          if (hashes[keys[i]] == hashes[keys[j]])
+            throw std::logic_error(
+                m.data[keys[i]].first == m.data[keys[j]].first
+                    ? "duplicate key in perfect_map"
+                    : "hash collision in perfect_map");
+
+      std::uint32_t seed = 0;
+      for (;; seed++) {
+        if (seed == (1u << 20))
+          throw std::logic_error("no perfect hash seed found");
+        bool ok = true;
+        for (std::size_t i = 0; i < len && ok; i++) {
+          trial[i] = map_type::slot(hashes[keys[i]], seed);
+          ok = order[trial[i]] == none;
+          for (std::size_t j = 0; j < i && ok; j++)
+            ok = trial[i] != trial[j];
+        }
+        if (ok)
+          break;
+      }
+
+      seeds[b] = seed;
+      for (std::size_t i = 0; i < len; i++)
+        order[trial[i]] = keys[i];
+    }
+  }
+
+  return std::make_pair(seeds, order);
+}
+
+} // namespace detail
+
+/**
+ * @brief Build a perfect_map from a constexpr_map at compile time.
+ *
+ * @tparam hash The hash functor, see constexpr_hash.
+ * @param m The source map.
+ * @return A perfect_map holding the same entries.
+ */
+template <typename hash = void, typename key, typename value, std::size_t size>
+consteval auto make_perfect_map(const constexpr_map<key, value, size> &m) {
+  using hash_type =
+      std::conditional_t<std::is_void_v<hash>, constexpr_hash<key>, hash>;
+  const auto [seeds, order] =
+      detail::build_perfect_hash<key, value, size, hash_type>(m);
+  return [&]<std::size_t... I>(std::index_sequence<I...>) {
+    return perfect_map<key, value, size, hash_type>{{m.data[order[I]]...},
+                                                    seeds};
+  }(std::make_index_sequence<size>{});
+}
+
 #endif
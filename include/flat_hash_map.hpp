@@ -0,0 +1,451 @@
+#ifndef EXSTD_FLAT_HASH_MAP_HPP
+#define EXSTD_FLAT_HASH_MAP_HPP
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <new>
+#include <span>
+#include <type_traits>
+#include <utility>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "constexpr_map.hpp"
+
+/**
+ * @file flat_hash_map.hpp
+ * @brief Definition of the flat_hash_map template struct.
+ */
+
+/**
+ * @brief Default hash for flat_hash_map.
+ *
+ * Uses constexpr_hash when it is defined for the key, so a flat_hash_map and
+ * a perfect_map built from the same constexpr_map hash keys the same way.
+ * Falls back to a mixed std::hash otherwise, since the low bits of std::hash
+ * are often the identity.
+ *
+ * @tparam key The type to hash.
+ */
+template <typename key> struct flat_hash {
+  std::uint64_t operator()(const key &k) const noexcept {
+    if constexpr (requires { constexpr_hash<key>{}(k); })
+      return constexpr_hash<key>{}(k);
+    else
+      return constexpr_mix(std::hash<key>{}(k));
+  }
+};
+
+/**
+ * @brief A runtime-growable open-addressing hash map.
+ *
+ * The `flat_hash_map` keeps its control bytes, keys and values in three
+ * separate arrays, so probing only touches the control bytes and the keys
+ * of candidate slots. Lookups compare 16 control bytes at once (SSE2 when
+ * available, a scalar loop otherwise) in the style of SwissTable: every
+ * full slot stores 7 bits of the key hash, and a group containing an empty
+ * slot ends the probe sequence.
+ *
+ * @tparam key The type of keys in the map.
+ * @tparam value The type of values associated with the keys.
+ * @tparam hash The hash functor, returning a 64-bit hash.
+ */
+template <typename key, typename value, typename hash = flat_hash<key>>
+struct flat_hash_map {
+  static constexpr std::size_t group_width = 16;
+
+  /**
+   * @brief Construct an empty map. No memory is allocated.
+   */
+  flat_hash_map() = default;
+
+  /**
+   * @brief Construct a map holding the entries of a constexpr_map.
+   *
+   * @param m The map to copy the entries from.
+   */
+  template <std::size_t size>
+  explicit flat_hash_map(const constexpr_map<key, value, size> &m) {
+    reserve(size);
+    for (const auto &[k, v] : m.data)
+      try_emplace(k, v);
+  }
+
+  flat_hash_map(const flat_hash_map &other) { *this = other; }
+
+  flat_hash_map(flat_hash_map &&other) noexcept { swap(other); }
+
+  flat_hash_map &operator=(const flat_hash_map &other) {
+    if (this == &other)
+      return *this;
+    clear();
+    reserve(other.count);
+    other.for_each(
+        [this](const key &k, const value &v) { try_emplace(k, v); });
+    return *this;
+  }
+
+  flat_hash_map &operator=(flat_hash_map &&other) noexcept {
+    flat_hash_map tmp(std::move(other));
+    swap(tmp);
+    return *this;
+  }
+
+  /**
+   * @brief Destructor. Destroys all entries and releases the storage.
+   */
+  ~flat_hash_map() {
+    destroy_all();
+    deallocate(ctrl, keys, values, capacity);
+  }
+
+  void swap(flat_hash_map &other) noexcept {
+    std::swap(ctrl, other.ctrl);
+    std::swap(keys, other.keys);
+    std::swap(values, other.values);
+    std::swap(capacity, other.capacity);
+    std::swap(count, other.count);
+    std::swap(growth_left, other.growth_left);
+  }
+
+  /**
+   * @brief Find the value associated with a key.
+   *
+   * @param k The key to look up.
+   * @return A pointer to the value, or nullptr if the key is not in the map.
+   */
+  [[nodiscard]] value *find(const key &k) noexcept {
+    return find_hashed(k, hash{}(k));
+  }
+
+  [[nodiscard]] const value *find(const key &k) const noexcept {
+    return find_hashed(k, hash{}(k));
+  }
+
+  /**
+   * @brief Look up a batch of keys.
+   *
+   * Hashes a block of keys and prefetches their first probe group before
+   * probing any of them, so the cache misses of the block overlap instead of
+   * being paid one after the other.
+   *
+   * @param ks The keys to look up.
+   * @param out Receives a pointer to the value of each key, or nullptr.
+   * @return The number of keys that were found.
+   */
+  std::size_t find_many(std::span<const key> ks, std::span<value *> out) {
+    return find_many_impl(*this, ks, out);
+  }
+
+  std::size_t find_many(std::span<const key> ks,
+                        std::span<const value *> out) const {
+    return find_many_impl(*this, ks, out);
+  }
+
+  /**
+   * @brief Check whether a key is in the map.
+   *
+   * @param k The key to look up.
+   * @return True if the key is present, false otherwise.
+   */
+  [[nodiscard]] bool contains(const key &k) const noexcept {
+    return find(k) != nullptr;
+  }
+
+  /**
+   * @brief Insert a value constructed from args if the key is not present.
+   *
+   * @param k The key to insert.
+   * @param args Arguments forwarded to the value constructor.
+   * @return A pointer to the value for k, and true if it was inserted.
+   */
+  template <typename K, typename... Args>
+  std::pair<value *, bool> try_emplace(K &&k, Args &&...args) {
+    const std::uint64_t h = hash{}(k);
+    if (value *v = find_hashed(k, h))
+      return {v, false};
+    if (growth_left == 0)
+      grow();
+
+    const std::size_t i = find_free(h);
+    if (ctrl[i] == ctrl_empty)
+      growth_left--;
+    ::new (static_cast<void *>(keys + i)) key(std::forward<K>(k));
+    ::new (static_cast<void *>(values + i))
+        value(std::forward<Args>(args)...);
+    set_ctrl(i, static_cast<std::int8_t>(h & 0x7f));
+    count++;
+    return {values + i, true};
+  }
+
+  /**
+   * @brief Insert or overwrite the value for a key.
+   *
+   * @param k The key to insert.
+   * @param v The value to store.
+   * @return True if the key was inserted, false if it was overwritten.
+   */
+  template <typename K, typename V> bool insert_or_assign(K &&k, V &&v) {
+    auto [slot, inserted] =
+        try_emplace(std::forward<K>(k), std::forward<V>(v));
+    if (!inserted)
+      *slot = std::forward<V>(v);
+    return inserted;
+  }
+
+  /**
+   * @brief Access the value for a key, default constructing it if needed.
+   *
+   * @param k The key to look up.
+   * @return A reference to the value.
+   */
+  value &operator[](const key &k) { return *try_emplace(k).first; }
+
+  /**
+   * @brief Remove a key from the map.
+   *
+   * @param k The key to remove.
+   * @return True if the key was present.
+   */
+  bool erase(const key &k) {
+    value *v = find(k);
+    if (!v)
+      return false;
+    const std::size_t i = static_cast<std::size_t>(v - values);
+    std::destroy_at(keys + i);
+    std::destroy_at(values + i);
+    set_ctrl(i, ctrl_deleted);
+    count--;
+    return true;
+  }
+
+  /**
+   * @brief Remove all entries, keeping the storage.
+   */
+  void clear() {
+    destroy_all();
+    if (capacity) {
+      std::memset(ctrl, ctrl_empty, capacity + group_width);
+      growth_left = max_load(capacity);
+    }
+    count = 0;
+  }
+
+  /**
+   * @brief Make room for at least n entries without rehashing.
+   *
+   * @param n The number of entries to make room for.
+   */
+  void reserve(std::size_t n) {
+    std::size_t cap = capacity ? capacity : group_width;
+    while (max_load(cap) < n)
+      cap *= 2;
+    if (cap != capacity)
+      rehash(cap);
+  }
+
+  /**
+   * @brief Call fn(key, value) for every entry, in slot order.
+   *
+   * @param fn The function to call.
+   */
+  template <typename Fn> void for_each(Fn &&fn) {
+    for (std::size_t i = 0; i < capacity; i++)
+      if (ctrl[i] >= 0)
+        fn(std::as_const(keys[i]), values[i]);
+  }
+
+  template <typename Fn> void for_each(Fn &&fn) const {
+    for (std::size_t i = 0; i < capacity; i++)
+      if (ctrl[i] >= 0)
+        fn(keys[i], std::as_const(values[i]));
+  }
+
+  [[nodiscard]] std::size_t size() const noexcept { return count; }
+  [[nodiscard]] bool empty() const noexcept { return count == 0; }
+
+private:
+  static constexpr std::int8_t ctrl_empty = -128;
+  static constexpr std::int8_t ctrl_deleted = -2;
+
+  /**
+   * @brief A group of 16 control bytes starting at an arbitrary slot.
+   *
+   * Each match returns a bitmask with bit i set when byte i matches.
+   */
+  struct group {
+#ifdef __SSE2__
+    __m128i bytes;
+
+    explicit group(const std::int8_t *p)
+        : bytes(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p))) {}
+
+    std::uint32_t match(std::int8_t h2) const {
+      return static_cast<std::uint32_t>(
+          _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), bytes)));
+    }
+
+    std::uint32_t match_empty_or_deleted() const {
+      // Empty and deleted are the only control values below -1.
+      return static_cast<std::uint32_t>(
+          _mm_movemask_epi8(_mm_cmpgt_epi8(_mm_set1_epi8(-1), bytes)));
+    }
+#else
+    const std::int8_t *bytes;
+
+    explicit group(const std::int8_t *p) : bytes(p) {}
+
+    std::uint32_t match(std::int8_t h2) const {
+      std::uint32_t m = 0;
+      for (std::size_t i = 0; i < group_width; i++)
+        m |= static_cast<std::uint32_t>(bytes[i] == h2) << i;
+      return m;
+    }
+
+    std::uint32_t match_empty_or_deleted() const {
+      std::uint32_t m = 0;
+      for (std::size_t i = 0; i < group_width; i++)
+        m |= static_cast<std::uint32_t>(bytes[i] < -1) << i;
+      return m;
+    }
+#endif
+
+    std::uint32_t match_empty() const { return match(ctrl_empty); }
+  };
+
+  static constexpr std::size_t max_load(std::size_t cap) noexcept {
+    return cap - cap / 8;
+  }
+
+  template <typename Self, typename Out>
+  static std::size_t find_many_impl(Self &self, std::span<const key> ks,
+                                    Out out) {
+    constexpr std::size_t block = 16;
+    const std::size_t n = std::min(ks.size(), out.size());
+    std::uint64_t hashes[block];
+    std::size_t found = 0;
+    for (std::size_t base = 0; base < n; base += block) {
+      const std::size_t len = std::min(block, n - base);
+      for (std::size_t i = 0; i < len; i++) {
+        hashes[i] = hash{}(ks[base + i]);
+        if (self.capacity)
+          __builtin_prefetch(self.ctrl +
+                             ((hashes[i] >> 7) & (self.capacity - 1)));
+      }
+      for (std::size_t i = 0; i < len; i++) {
+        out[base + i] = self.find_hashed(ks[base + i], hashes[i]);
+        found += out[base + i] != nullptr;
+      }
+    }
+    return found;
+  }
+
+  template <typename K>
+  value *find_hashed(const K &k, std::uint64_t h) const noexcept {
+    if (capacity == 0)
+      return nullptr;
+    const std::size_t mask = capacity - 1;
+    const auto h2 = static_cast<std::int8_t>(h & 0x7f);
+    std::size_t pos = (h >> 7) & mask;
+    for (std::size_t step = group_width;; step += group_width) {
+      const group g(ctrl + pos);
+      for (std::uint32_t m = g.match(h2); m; m &= m - 1) {
+        const std::size_t i = (pos + std::countr_zero(m)) & mask;
+        if (keys[i] == k)
+          return values + i;
+      }
+      if (g.match_empty())
+        return nullptr;
+      pos = (pos + step) & mask;
+    }
+  }
+
+  std::size_t find_free(std::uint64_t h) const noexcept {
+    const std::size_t mask = capacity - 1;
+    std::size_t pos = (h >> 7) & mask;
+    for (std::size_t step = group_width;; step += group_width) {
+      if (std::uint32_t m = group(ctrl + pos).match_empty_or_deleted())
+        return (pos + std::countr_zero(m)) & mask;
+      pos = (pos + step) & mask;
+    }
+  }
+
+  void set_ctrl(std::size_t i, std::int8_t c) noexcept {
+    ctrl[i] = c;
+    // The first group is mirrored past the end so groups never wrap.
+    if (i < group_width)
+      ctrl[capacity + i] = c;
+  }
+
+  void grow() {
+    // Tombstones count against growth_left; purge them in place when the
+    // table is mostly tombstones rather than doubling.
+    rehash(count * 2 < max_load(capacity)
+               ? capacity
+               : std::max(capacity * 2, group_width));
+  }
+
+  void rehash(std::size_t new_capacity) {
+    std::int8_t *old_ctrl = ctrl;
+    key *old_keys = keys;
+    value *old_values = values;
+    const std::size_t old_capacity = capacity;
+
+    ctrl = new std::int8_t[new_capacity + group_width];
+    keys = std::allocator<key>().allocate(new_capacity);
+    values = std::allocator<value>().allocate(new_capacity);
+    std::memset(ctrl, ctrl_empty, new_capacity + group_width);
+    capacity = new_capacity;
+    growth_left = max_load(new_capacity) - count;
+
+    for (std::size_t i = 0; i < old_capacity; i++) {
+      if (old_ctrl[i] < 0)
+        continue;
+      const std::uint64_t h = hash{}(old_keys[i]);
+      const std::size_t j = find_free(h);
+      ::new (static_cast<void *>(keys + j)) key(std::move(old_keys[i]));
+      ::new (static_cast<void *>(values + j)) value(std::move(old_values[i]));
+      set_ctrl(j, static_cast<std::int8_t>(h & 0x7f));
+      std::destroy_at(old_keys + i);
+      std::destroy_at(old_values + i);
+    }
+    deallocate(old_ctrl, old_keys, old_values, old_capacity);
+  }
+
+  void destroy_all() noexcept {
+    if constexpr (!std::is_trivially_destructible_v<key> ||
+                  !std::is_trivially_destructible_v<value>) {
+      for (std::size_t i = 0; i < capacity; i++) {
+        if (ctrl[i] >= 0) {
+          std::destroy_at(keys + i);
+          std::destroy_at(values + i);
+        }
+      }
+    }
+  }
+
+  static void deallocate(std::int8_t *c, key *k, value *v,
+                         std::size_t cap) noexcept {
+    if (!cap)
+      return;
+    delete[] c;
+    std::allocator<key>().deallocate(k, cap);
+    std::allocator<value>().deallocate(v, cap);
+  }
+
+  std::int8_t *ctrl = nullptr; ///< Control bytes, capacity + group_width.
+  key *keys = nullptr;         ///< Keys, indexed like ctrl.
+  value *values = nullptr;     ///< Values, indexed like ctrl.
+  std::size_t capacity = 0;    ///< Number of slots, a power of two or 0.
+  std::size_t count = 0;       ///< Number of entries.
+  std::size_t growth_left = 0; ///< Inserts left before a rehash.
+};
+
+#endif
@@ -1,11 +1,24 @@
 #ifndef EXSTD_SINGLETON_HPP
 #define EXSTD_SINGLETON_HPP
 
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
 /**
  * @file singleton.hpp
- * @brief Definition of the singleton template struct.
+ * @brief Definition of the singleton template structs.
  */
 
+/**
+ * @brief Alignment used to keep per-thread data on separate cache lines.
+ */
+inline constexpr std::size_t cache_line_size = 64;
+
 /**
  * @brief A template struct for creating a singleton instance
  *
@@ -53,4 +66,191 @@ protected:
   ~singleton() = default;
 };
 
+/**
+ * @brief A template struct giving every thread its own instance.
+ *
+ * Each thread gets a cache-line aligned instance of T the first time it calls
+ * instance() or init(), so writes from different threads never share a cache
+ * line. When a thread exits its instance is kept, with its contents, and
+ * handed to the next new thread; aggregate() therefore still sees what exited
+ * threads wrote. Members read through aggregate() while other threads write
+ * them should be relaxed atomics.
+ *
+ * A thread never re-attaches once its instance has been released: instance()
+ * called later from its thread_local destructors returns a spill instance
+ * shared by all such threads, and try_instance() returns nullptr so callers
+ * can take a path that is safe for that.
+ *
+ * @tparam T The type of the per-thread instance.
+ */
+template <typename T> struct thread_singleton {
+public:
+  thread_singleton(const thread_singleton &) = delete;
+  thread_singleton &operator=(const thread_singleton &) = delete;
+
+  /**
+   * @brief Access the instance of the calling thread.
+   *
+   * After the first call on a thread this is a single thread-local load and
+   * null check, there is no initialization guard.
+   *
+   * @return A reference to the instance of the calling thread.
+   */
+  static T &instance() {
+    if (!local) [[unlikely]]
+      init();
+    return *local;
+  }
+
+  /**
+   * @brief Access the instance of the calling thread unless it was released.
+   *
+   * @return The instance of the calling thread, or nullptr when called from a
+   * thread_local destructor after the instance has been released.
+   */
+  static T *try_instance() {
+    if (detached) [[unlikely]]
+      return nullptr;
+    return &instance();
+  }
+
+  /**
+   * @brief Attach the calling thread to its instance ahead of time.
+   *
+   * Call this at thread start to take the first-use cost off the hot path.
+   */
+  static void init() {
+    if (local)
+      return;
+    if (detached) {
+      local = &registry().spill.value;
+      return;
+    }
+
+    static thread_local releaser release;
+    registry_type &reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    shard *free = nullptr;
+    for (const auto &s : reg.shards) {
+      if (!s->in_use) {
+        free = s.get();
+        break;
+      }
+    }
+    if (!free)
+      free = reg.shards.emplace_back(std::make_unique<shard>()).get();
+
+    free->in_use = true;
+    release.owned = free;
+    local = &free->value;
+  }
+
+  /**
+   * @brief Visit the instance of every thread.
+   *
+   * @param fn Called with a const reference to each instance.
+   */
+  template <typename Fn> static void aggregate(Fn &&fn) {
+    registry_type &reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    for (const auto &s : reg.shards)
+      fn(std::as_const(s->value));
+    fn(std::as_const(reg.spill.value));
+  }
+
+protected:
+  thread_singleton() = default;
+  ~thread_singleton() = default;
+
+private:
+  struct alignas(cache_line_size) shard {
+    T value{};
+    bool in_use = false;
+  };
+
+  struct registry_type {
+    std::mutex mutex;
+    std::vector<std::unique_ptr<shard>> shards;
+    shard spill; ///< Shared by threads past their release.
+  };
+
+  /**
+   * @brief Returns the shard of an exiting thread to the registry.
+   */
+  struct releaser {
+    shard *owned = nullptr;
+
+    ~releaser() {
+      std::lock_guard<std::mutex> lock(registry().mutex);
+      owned->in_use = false;
+      local = nullptr;
+      detached = true;
+    }
+  };
+
+  static registry_type &registry() {
+    // Never destroyed, so threads exiting during shutdown can still use it.
+    static registry_type *reg = new registry_type;
+    return *reg;
+  }
+
+  static inline thread_local T *local = nullptr;
+  static inline thread_local bool detached = false;
+};
+
+/**
+ * @brief A template struct spreading threads over a fixed set of instances.
+ *
+ * The instances are cache-line aligned and created during static
+ * initialization, so instance() has no initialization guard. Threads are
+ * assigned to a shard round-robin on first use. Several threads may share a
+ * shard, so T has to be safe for concurrent use (relaxed atomics for
+ * counters); contention is divided by the number of shards. Do not use it
+ * from other static initializers unless T is constant-initialized.
+ *
+ * @tparam T The type of the instances.
+ * @tparam shards The number of instances.
+ */
+template <typename T, std::size_t shards = 16> struct sharded_singleton {
+public:
+  sharded_singleton(const sharded_singleton &) = delete;
+  sharded_singleton &operator=(const sharded_singleton &) = delete;
+
+  /**
+   * @brief Access the shard of the calling thread.
+   *
+   * @return A reference to the shard of the calling thread.
+   */
+  static T &instance() noexcept {
+    if (slot == unassigned) [[unlikely]]
+      slot = next_slot.fetch_add(1, std::memory_order_relaxed) % shards;
+    return storage[slot].value;
+  }
+
+  /**
+   * @brief Visit every shard.
+   *
+   * @param fn Called with a const reference to each shard.
+   */
+  template <typename Fn> static void aggregate(Fn &&fn) {
+    for (const auto &s : storage)
+      fn(s.value);
+  }
+
+protected:
+  sharded_singleton() = default;
+  ~sharded_singleton() = default;
+
+private:
+  struct alignas(cache_line_size) shard {
+    T value{};
+  };
+
+  static constexpr std::size_t unassigned = shards;
+
+  static inline std::array<shard, shards> storage{};
+  static inline std::atomic<std::size_t> next_slot{0};
+  static inline thread_local std::size_t slot = unassigned;
+};
+
 #endif
@@ -0,0 +1,453 @@
+#ifndef EXSTD_TRACE_HPP
+#define EXSTD_TRACE_HPP
+
+/**
+ * @file trace.hpp
+ * @brief Low-overhead timers, counters, histograms and event tracing.
+ *
+ * Everything is compiled out unless EXSTD_TRACE is defined: the probe macros
+ * expand to nothing (EXSTD_TRACE_LOCK to a plain lock) and the dump functions
+ * write empty documents. Probes should therefore only be used through the
+ * macros, and metric objects declared under `#ifdef EXSTD_TRACE`.
+ */
+
+#include <ostream>
+
+#ifdef EXSTD_TRACE
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ios>
+#include <iomanip>
+#include <mutex>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "singleton.hpp"
+
+/**
+ * @brief Cheap timestamp source.
+ *
+ * Reads the TSC on x86 and std::chrono::steady_clock elsewhere. Ticks are
+ * converted to nanoseconds only when dumping.
+ */
+struct trace_clock {
+  static std::uint64_t now() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+#endif
+  }
+
+  /**
+   * @brief Nanoseconds per tick, measured against steady_clock on first use.
+   */
+  static double ns_per_tick() {
+#if defined(__x86_64__) || defined(__i386__)
+    static const double ratio = [] {
+      using namespace std::chrono;
+      const auto t0 = steady_clock::now();
+      const std::uint64_t c0 = now();
+      while (steady_clock::now() - t0 < milliseconds(10)) {
+      }
+      const auto ns = duration_cast<nanoseconds>(steady_clock::now() - t0);
+      return double(ns.count()) / double(now() - c0);
+    }();
+    return ratio;
+#else
+    return 1.0;
+#endif
+  }
+};
+
+/**
+ * @brief Index of the calling thread among metric shards.
+ */
+inline std::size_t trace_shard() noexcept {
+  static constexpr std::size_t unassigned = ~std::size_t(0);
+  static std::atomic<std::size_t> next{0};
+  static thread_local std::size_t shard = unassigned;
+  if (shard == unassigned) [[unlikely]]
+    shard = next.fetch_add(1, std::memory_order_relaxed);
+  return shard;
+}
+
+struct trace_counter;
+struct trace_histogram;
+
+/**
+ * @brief All live counters and histograms, for the dump functions.
+ */
+struct trace_registry {
+  std::mutex mutex;
+  std::vector<trace_counter *> counters;
+  std::vector<trace_histogram *> histograms;
+
+  static trace_registry &instance() {
+    static trace_registry registry;
+    return registry;
+  }
+};
+
+/**
+ * @brief A named monotonically increasing counter.
+ *
+ * Increments go to one of several cache-line separated shards chosen by
+ * thread, so concurrent writers rarely share a line.
+ */
+struct trace_counter {
+  static constexpr std::size_t shards = 8;
+
+  explicit trace_counter(const char *name) : name(name) {
+    trace_registry &r = trace_registry::instance();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    r.counters.push_back(this);
+  }
+
+  trace_counter(const trace_counter &) = delete;
+  trace_counter &operator=(const trace_counter &) = delete;
+
+  ~trace_counter() {
+    trace_registry &r = trace_registry::instance();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    std::erase(r.counters, this);
+  }
+
+  void add(std::uint64_t n = 1) noexcept {
+    cells[trace_shard() % shards].value.fetch_add(n,
+                                                  std::memory_order_relaxed);
+  }
+
+  [[nodiscard]] std::uint64_t value() const noexcept {
+    std::uint64_t sum = 0;
+    for (const auto &c : cells)
+      sum += c.value.load(std::memory_order_relaxed);
+    return sum;
+  }
+
+  const char *name;
+
+private:
+  struct alignas(cache_line_size) cell {
+    std::atomic<std::uint64_t> value{0};
+  };
+
+  std::array<cell, shards> cells;
+};
+
+/**
+ * @brief A named log-linear histogram in the style of HdrHistogram.
+ *
+ * Values are bucketed by their highest set bit and the three bits below it,
+ * so every bucket is within 12.5% of the values it holds. Recording is one
+ * relaxed increment on a per-thread shard, plus a compare-and-swap when the
+ * value is a new maximum, which is tracked exactly.
+ */
+struct trace_histogram {
+  static constexpr std::size_t shards = 4;
+  static constexpr std::size_t sub_bits = 3;
+  static constexpr std::size_t sub_buckets = std::size_t(1) << sub_bits;
+  static constexpr std::size_t buckets = (64 - sub_bits + 1) * sub_buckets;
+
+  /**
+   * @brief Constructor.
+   * @param name The name of the histogram.
+   * @param duration Whether values are trace_clock ticks, dumped as ns.
+   */
+  explicit trace_histogram(const char *name, bool duration = true)
+      : name(name), duration(duration) {
+    trace_registry &r = trace_registry::instance();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    r.histograms.push_back(this);
+  }
+
+  trace_histogram(const trace_histogram &) = delete;
+  trace_histogram &operator=(const trace_histogram &) = delete;
+
+  ~trace_histogram() {
+    trace_registry &r = trace_registry::instance();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    std::erase(r.histograms, this);
+  }
+
+  void record(std::uint64_t v) noexcept {
+    shard &s = shard_cells[trace_shard() % shards];
+    s.counts[bucket(v)].fetch_add(1, std::memory_order_relaxed);
+    std::uint64_t m = s.max.load(std::memory_order_relaxed);
+    while (v > m &&
+           !s.max.compare_exchange_weak(m, v, std::memory_order_relaxed))
+      ;
+  }
+
+  /**
+   * @brief Merge the shards into one bucket array.
+   */
+  [[nodiscard]] std::array<std::uint64_t, buckets> snapshot() const noexcept {
+    std::array<std::uint64_t, buckets> merged{};
+    for (const auto &s : shard_cells)
+      for (std::size_t b = 0; b < buckets; b++)
+        merged[b] += s.counts[b].load(std::memory_order_relaxed);
+    return merged;
+  }
+
+  /**
+   * @brief The largest value recorded, exact rather than bucketed.
+   */
+  [[nodiscard]] std::uint64_t max() const noexcept {
+    std::uint64_t m = 0;
+    for (const auto &s : shard_cells)
+      m = std::max(m, s.max.load(std::memory_order_relaxed));
+    return m;
+  }
+
+  static std::size_t bucket(std::uint64_t v) noexcept {
+    if (v < sub_buckets)
+      return v;
+    const std::size_t e = std::bit_width(v) - 1;
+    const std::size_t sub = (v >> (e - sub_bits)) & (sub_buckets - 1);
+    return (e - sub_bits + 1) * sub_buckets + sub;
+  }
+
+  /**
+   * @brief Smallest value that falls in a bucket.
+   */
+  static std::uint64_t lower_bound(std::size_t b) noexcept {
+    if (b < sub_buckets)
+      return b;
+    const std::size_t e = b / sub_buckets + sub_bits - 1;
+    return (sub_buckets + b % sub_buckets) << (e - sub_bits);
+  }
+
+  const char *name;
+  bool duration;
+
+private:
+  struct alignas(cache_line_size) shard {
+    std::array<std::atomic<std::uint64_t>, buckets> counts{};
+    std::atomic<std::uint64_t> max{0};
+  };
+
+  std::array<shard, shards> shard_cells;
+};
+
+/**
+ * @brief A completed timed scope.
+ */
+struct trace_event {
+  const char *name;
+  std::uint64_t start;
+  std::uint64_t duration;
+};
+
+/**
+ * @brief Per-thread ring of the most recent trace events.
+ *
+ * Only the owning thread writes; the newest `capacity` events are kept. Each
+ * slot is a seqlock tagged with the index of its event, so a dump running
+ * while threads are still tracing skips events overwritten under it instead
+ * of reading them torn.
+ */
+struct trace_ring {
+  static constexpr std::size_t capacity = 4096;
+
+  void push(const trace_event &e) noexcept {
+    const std::uint64_t h = head.load(std::memory_order_relaxed);
+    slot &s = slots[h % capacity];
+    // Odd while being written. The release stores keep it ahead of the fields.
+    s.seq.store(2 * h + 1, std::memory_order_relaxed);
+    s.name.store(e.name, std::memory_order_release);
+    s.start.store(e.start, std::memory_order_release);
+    s.duration.store(e.duration, std::memory_order_release);
+    s.seq.store(2 * h + 2, std::memory_order_release);
+    head.store(h + 1, std::memory_order_release);
+  }
+
+  /**
+   * @brief Read event i, which may be concurrently overwritten.
+   *
+   * @param i The index of the event, below head.
+   * @param e Receives the event.
+   * @return False if the slot no longer (or not yet) holds event i.
+   */
+  bool read(std::uint64_t i, trace_event &e) const noexcept {
+    const slot &s = slots[i % capacity];
+    if (s.seq.load(std::memory_order_acquire) != 2 * i + 2)
+      return false;
+    e.name = s.name.load(std::memory_order_acquire);
+    e.start = s.start.load(std::memory_order_acquire);
+    e.duration = s.duration.load(std::memory_order_acquire);
+    return s.seq.load(std::memory_order_relaxed) == 2 * i + 2;
+  }
+
+  struct slot {
+    std::atomic<std::uint64_t> seq{0};
+    std::atomic<const char *> name{nullptr};
+    std::atomic<std::uint64_t> start{0};
+    std::atomic<std::uint64_t> duration{0};
+  };
+
+  std::array<slot, capacity> slots{};
+  std::atomic<std::uint64_t> head{0};
+  std::uint32_t id = next_id.fetch_add(1, std::memory_order_relaxed);
+
+  static inline std::atomic<std::uint32_t> next_id{1};
+};
+
+/**
+ * @brief Times a scope into a histogram and the thread's event ring.
+ */
+struct trace_timer {
+  /**
+   * @brief Constructor. Starts the timer.
+   * @param name The event name, must outlive the trace (a literal).
+   * @param hist The histogram receiving the duration in ticks.
+   */
+  trace_timer(const char *name, trace_histogram &hist) noexcept
+      : name(name), hist(hist), start(trace_clock::now()) {}
+
+  trace_timer(const trace_timer &) = delete;
+  trace_timer &operator=(const trace_timer &) = delete;
+
+  /**
+   * @brief Destructor. Records the elapsed time.
+   */
+  ~trace_timer() {
+    const std::uint64_t elapsed = trace_clock::now() - start;
+    hist.record(elapsed);
+    // The ring has a single writer, so none is shared after thread exit.
+    if (trace_ring *ring = thread_singleton<trace_ring>::try_instance())
+      ring->push({name, start, elapsed});
+  }
+
+  const char *name;
+  trace_histogram &hist;
+  std::uint64_t start;
+};
+
+/**
+ * @brief Write the events of all threads in Chrome trace JSON format.
+ *
+ * The output can be loaded in chrome://tracing or Perfetto.
+ *
+ * @param out The stream to write to.
+ */
+inline void trace_dump_chrome(std::ostream &out) {
+  const double us_per_tick = trace_clock::ns_per_tick() / 1000.0;
+  const std::ios_base::fmtflags flags = out.flags();
+  const std::streamsize precision = out.precision();
+  bool first = true;
+  out << std::fixed << std::setprecision(3) << "{\"traceEvents\":[";
+  thread_singleton<trace_ring>::aggregate([&](const trace_ring &ring) {
+    const std::uint64_t h = ring.head.load(std::memory_order_acquire);
+    const std::uint64_t begin = h > trace_ring::capacity
+                                    ? h - trace_ring::capacity
+                                    : 0;
+    for (std::uint64_t i = begin; i < h; i++) {
+      trace_event e;
+      if (!ring.read(i, e))
+        continue;
+      out << (first ? "" : ",") << "\n{\"name\":\"" << e.name
+          << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << ring.id
+          << ",\"ts\":" << double(e.start) * us_per_tick
+          << ",\"dur\":" << double(e.duration) * us_per_tick << "}";
+      first = false;
+    }
+  });
+  out << "\n]}\n";
+  out.flags(flags);
+  out.precision(precision);
+}
+
+/**
+ * @brief Write all counters and histogram summaries as JSON.
+ *
+ * Duration histograms are reported in nanoseconds.
+ *
+ * @param out The stream to write to.
+ */
+inline void trace_dump_json(std::ostream &out) {
+  trace_registry &r = trace_registry::instance();
+  std::lock_guard<std::mutex> lock(r.mutex);
+
+  out << "{\"counters\":{";
+  for (std::size_t i = 0; i < r.counters.size(); i++)
+    out << (i ? "," : "") << "\n\"" << r.counters[i]->name
+        << "\":" << r.counters[i]->value();
+
+  out << "\n},\"histograms\":{";
+  for (std::size_t i = 0; i < r.histograms.size(); i++) {
+    const trace_histogram &h = *r.histograms[i];
+    const auto counts = h.snapshot();
+    std::uint64_t total = 0;
+    for (const std::uint64_t c : counts)
+      total += c;
+    const double scale = h.duration ? trace_clock::ns_per_tick() : 1.0;
+    const auto percentile = [&](double p) {
+      const auto rank = std::min(std::uint64_t(p * double(total)),
+                                 total ? total - 1 : 0);
+      std::uint64_t seen = 0;
+      for (std::size_t b = 0; b < counts.size(); b++) {
+        seen += counts[b];
+        if (counts[b] && seen > rank)
+          return double(trace_histogram::lower_bound(b)) * scale;
+      }
+      return 0.0;
+    };
+
+    out << (i ? "," : "") << "\n\"" << h.name << "\":{\"count\":" << total
+        << ",\"p50\":" << percentile(0.5) << ",\"p90\":" << percentile(0.9)
+        << ",\"p99\":" << percentile(0.99)
+        << ",\"p999\":" << percentile(0.999)
+        << ",\"max\":" << double(h.max()) * scale << "}";
+  }
+  out << "\n}}\n";
+}
+
+#define EXSTD_TRACE_CAT_(a, b) a##b
+#define EXSTD_TRACE_CAT(a, b) EXSTD_TRACE_CAT_(a, b)
+
+/// Time the rest of the enclosing scope into a trace_histogram.
+#define EXSTD_TRACE_SCOPE(name, hist)                                          \
+  trace_timer EXSTD_TRACE_CAT(exstd_trace_timer_, __LINE__)(name, hist)
+/// Add n to a trace_counter.
+#define EXSTD_TRACE_ADD(counter, n) (counter).add(n)
+/// Record a value in a trace_histogram.
+#define EXSTD_TRACE_RECORD(hist, v) (hist).record(v)
+/// Lock a std::unique_lock, counting in a trace_counter if it was contended.
+#define EXSTD_TRACE_LOCK(lock, counter)                                        \
+  do {                                                                         \
+    if (!(lock).try_lock()) {                                                  \
+      (counter).add(1);                                                        \
+      (lock).lock();                                                           \
+    }                                                                          \
+  } while (0)
+
+#else
+
+inline void trace_dump_chrome(std::ostream &out) {
+  out << "{\"traceEvents\":[]}\n";
+}
+
+inline void trace_dump_json(std::ostream &out) {
+  out << "{\"counters\":{},\"histograms\":{}}\n";
+}
+
+#define EXSTD_TRACE_SCOPE(name, hist)
+#define EXSTD_TRACE_ADD(counter, n) ((void)0)
+#define EXSTD_TRACE_RECORD(hist, v) ((void)0)
+#define EXSTD_TRACE_LOCK(lock, counter) (lock).lock()
+
+#endif
+
+#endif
@@ -2,10 +2,20 @@
 #define EXSTD_TSQUEUE_HPP
 
 #include <condition_variable>
+#include <deque>
+#include <memory>
 #include <mutex>
 #include <optional>
 #include <queue>
 
+#include "trace.hpp"
+
+#ifdef EXSTD_TRACE
+inline trace_histogram ts_queue_depth{"ts_queue.depth", false};
+inline trace_histogram ts_queue_wait_time{"ts_queue.pop_wait"};
+inline trace_counter ts_queue_contended{"ts_queue.contended_locks"};
+#endif
+
 /**
  * @file ts_queue.hpp
  * @brief Definition of the ts_queue template struct.
@@ -18,12 +28,25 @@
  * queue, allowing safe concurrent access by multiple threads.
  *
  * @tparam T The type of elements stored in the queue.
+ * @tparam Allocator The allocator used for the queue storage, e.g.
+ * std::pmr::polymorphic_allocator<T> over a pool_resource.
  */
-template <typename T> struct ts_queue {
-  std::queue<T> internal;
+template <typename T, typename Allocator = std::allocator<T>> struct ts_queue {
+  std::queue<T, std::deque<T, Allocator>> internal;
   std::mutex access_mutex;
   std::condition_variable cond;
 
+  /**
+   * @brief Default constructor.
+   */
+  ts_queue() = default;
+
+  /**
+   * @brief Constructor using the given allocator for the queue storage.
+   * @param alloc The allocator.
+   */
+  explicit ts_queue(const Allocator &alloc) : internal(alloc) {}
+
   /**
    * @brief Push a value onto the queue.
    *
@@ -62,17 +85,25 @@ template <typename T> struct ts_queue {
   ~ts_queue() { cond.notify_all(); }
 };
 
-template <typename T> void ts_queue<T>::push(const T &value) {
+template <typename T, typename Allocator>
+void ts_queue<T, Allocator>::push(const T &value) {
   {
-    std::unique_lock<std::mutex> lock(access_mutex);
+    std::unique_lock<std::mutex> lock(access_mutex, std::defer_lock);
+    EXSTD_TRACE_LOCK(lock, ts_queue_contended);
     internal.push(value);
+    EXSTD_TRACE_RECORD(ts_queue_depth, internal.size());
   }
   cond.notify_one();
 }
 
-template <typename T> std::optional<T> ts_queue<T>::pop() {
-  std::unique_lock<std::mutex> lock(access_mutex);
-  cond.wait(lock, [this] { return !internal.empty(); });
+template <typename T, typename Allocator>
+std::optional<T> ts_queue<T, Allocator>::pop() {
+  std::unique_lock<std::mutex> lock(access_mutex, std::defer_lock);
+  EXSTD_TRACE_LOCK(lock, ts_queue_contended);
+  if (internal.empty()) {
+    EXSTD_TRACE_SCOPE("ts_queue.pop_wait", ts_queue_wait_time);
+    cond.wait(lock, [this] { return !internal.empty(); });
+  }
   if (internal.empty()) {
     return std::nullopt;
   }
@@ -82,7 +113,8 @@ template <typename T> std::optional<T> ts_queue<T>::pop() {
   return t;
 }
 
-template <typename T> bool ts_queue<T>::empty() {
+template <typename T, typename Allocator>
+bool ts_queue<T, Allocator>::empty() {
   std::lock_guard<std::mutex> lock(access_mutex);
   return internal.empty();
 }
@@ -0,0 +1,459 @@
+#ifndef EXSTD_UNROLLED_LIST_HPP
+#define EXSTD_UNROLLED_LIST_HPP
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/**
+ * @file unrolled_list.hpp
+ * @brief Definition of the unrolled_list template struct.
+ */
+
+/**
+ * @brief A sequence container storing its elements in fixed-size chunks.
+ *
+ * Elements are stored contiguously in heap-allocated chunks of up to
+ * chunk_size elements, linked to the next chunk. Chunks are never
+ * reallocated, and iterators refer to a chunk rather than to a position, so an
+ * insertion or erasure only invalidates references, iterators and slices into
+ * the chunk being modified (and, when a full chunk is split or two sparse
+ * chunks are merged, into the chunk elements are moved out of). Everything
+ * pointing into other chunks stays valid, as with std::list; unlike std::list,
+ * neighbours of the edited element in the same chunk are moved.
+ *
+ * A position index, a Fenwick tree over a contiguous array of chunk sizes,
+ * turns positional access and slicing into an O(log n) search that never
+ * reads chunk memory. Changing the size of a chunk updates it in O(log n);
+ * adding or removing a chunk in the middle rebuilds it in one linear pass
+ * over the size array, at most once every chunk_size / 2 edits.
+ *
+ * @tparam T The type of elements in the list.
+ * @tparam chunk_size The maximum number of elements per chunk.
+ */
+template <typename T, std::size_t chunk_size = 64> struct unrolled_list {
+  static_assert(chunk_size >= 2, "chunks must hold at least two elements");
+
+private:
+  struct chunk {
+    chunk *next = nullptr;
+    std::size_t count = 0;
+    alignas(T) std::byte storage[sizeof(T) * chunk_size];
+
+    T *data() noexcept { return std::launder(reinterpret_cast<T *>(storage)); }
+  };
+
+public:
+  /**
+   * @brief Forward iterator over the elements.
+   *
+   * @tparam is_const Whether the iterator yields const references.
+   */
+  template <bool is_const> struct basic_iterator {
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using reference = std::conditional_t<is_const, const T &, T &>;
+    using pointer = std::conditional_t<is_const, const T *, T *>;
+    using iterator_category = std::forward_iterator_tag;
+
+    basic_iterator() = default;
+    basic_iterator(chunk *c, std::size_t i) : c(c), i(i) {}
+
+    operator basic_iterator<true>() const { return {c, i}; }
+
+    reference operator*() const { return c->data()[i]; }
+    pointer operator->() const { return c->data() + i; }
+
+    basic_iterator &operator++() {
+      if (++i == c->count) {
+        c = c->next;
+        i = 0;
+      }
+      return *this;
+    }
+
+    basic_iterator operator++(int) {
+      basic_iterator tmp = *this;
+      ++*this;
+      return tmp;
+    }
+
+    bool operator==(const basic_iterator &other) const = default;
+
+  private:
+    friend struct unrolled_list;
+
+    chunk *c = nullptr; ///< The current chunk, nullptr at the end.
+    std::size_t i = 0;  ///< The index inside the current chunk.
+  };
+
+  using iterator = basic_iterator<false>;
+  using const_iterator = basic_iterator<true>;
+
+  /**
+   * @brief A non-owning view over a range of positions of the list.
+   *
+   * @tparam is_const Whether the view yields const references.
+   */
+  template <bool is_const> struct basic_slice {
+    using element = std::conditional_t<is_const, const T, T>;
+
+    basic_iterator<is_const> begin() const { return first; }
+    basic_iterator<is_const> end() const { return last; }
+    std::size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+
+    /**
+     * @brief Visit the slice as contiguous blocks of elements.
+     *
+     * @param fn Called with a std::span for the part of each chunk in the
+     * slice, in order.
+     */
+    template <typename Fn> void for_each_chunk(Fn &&fn) const {
+      chunk *c = first.c;
+      std::size_t offset = first.i;
+      for (std::size_t left = count; left > 0; c = c->next, offset = 0) {
+        const std::size_t n = std::min(left, c->count - offset);
+        fn(std::span<element>(c->data() + offset, n));
+        left -= n;
+      }
+    }
+
+    basic_iterator<is_const> first;
+    basic_iterator<is_const> last;
+    std::size_t count = 0;
+  };
+
+  using slice_type = basic_slice<false>;
+  using const_slice_type = basic_slice<true>;
+
+  unrolled_list() = default;
+
+  unrolled_list(const unrolled_list &other) {
+    for (const T &v : other)
+      push_back(v);
+  }
+
+  unrolled_list(unrolled_list &&other) noexcept { swap(other); }
+
+  unrolled_list &operator=(const unrolled_list &other) {
+    if (this != &other) {
+      unrolled_list tmp(other);
+      swap(tmp);
+    }
+    return *this;
+  }
+
+  unrolled_list &operator=(unrolled_list &&other) noexcept {
+    unrolled_list tmp(std::move(other));
+    swap(tmp);
+    return *this;
+  }
+
+  /**
+   * @brief Destructor. Destroys all elements and releases the chunks.
+   */
+  ~unrolled_list() { clear(); }
+
+  void swap(unrolled_list &other) noexcept {
+    std::swap(chunks, other.chunks);
+    std::swap(counts, other.counts);
+    std::swap(tree, other.tree);
+    std::swap(total, other.total);
+  }
+
+  iterator begin() { return {first_chunk(), 0}; }
+  iterator end() { return {}; }
+  const_iterator begin() const { return {first_chunk(), 0}; }
+  const_iterator end() const { return {}; }
+
+  [[nodiscard]] std::size_t size() const noexcept { return total; }
+  [[nodiscard]] bool empty() const noexcept { return total == 0; }
+
+  /**
+   * @brief Access the element at a position in O(log n).
+   *
+   * @param pos The position of the element.
+   * @return A reference to the element.
+   */
+  T &operator[](std::size_t pos) {
+    const auto [c, i] = locate(pos);
+    return chunks[c]->data()[i];
+  }
+
+  const T &operator[](std::size_t pos) const {
+    const auto [c, i] = locate(pos);
+    return chunks[c]->data()[i];
+  }
+
+  /**
+   * @brief Get a view of the positions [start, end).
+   *
+   * The view is found with two index searches and does not allocate. Both
+   * bounds are clamped to the size of the list.
+   *
+   * @param start The starting position of the slice.
+   * @param end The ending position (exclusive) of the slice.
+   * @return A view over the elements in the range.
+   */
+  slice_type slice(std::size_t start, std::size_t end) {
+    return make_slice<false>(start, end);
+  }
+
+  const_slice_type slice(std::size_t start, std::size_t end) const {
+    return make_slice<true>(start, end);
+  }
+
+  /**
+   * @brief Append an element.
+   *
+   * @param args Arguments forwarded to the element constructor.
+   * @return A reference to the new element.
+   */
+  template <typename... Args> T &emplace_back(Args &&...args) {
+    if (chunks.empty() || chunks.back()->count == chunk_size)
+      add_chunk(chunks.size());
+    chunk &c = *chunks.back();
+    T *v = std::construct_at(c.data() + c.count, std::forward<Args>(args)...);
+    resize_chunk(chunks.size() - 1, 1);
+    return *v;
+  }
+
+  void push_back(const T &value) { emplace_back(value); }
+  void push_back(T &&value) { emplace_back(std::move(value)); }
+
+  /**
+   * @brief Insert an element before a position.
+   *
+   * @param pos The position to insert at, at most size().
+   * @param args Arguments forwarded to the element constructor.
+   * @return A reference to the new element.
+   */
+  template <typename... Args> T &emplace(std::size_t pos, Args &&...args) {
+    if (pos >= total)
+      return emplace_back(std::forward<Args>(args)...);
+
+    auto [c, i] = locate(pos);
+    if (chunks[c]->count == chunk_size) {
+      split(c);
+      if (i >= chunks[c]->count) {
+        i -= chunks[c]->count;
+        c++;
+      }
+    }
+
+    chunk &target = *chunks[c];
+    T *d = target.data();
+    if (i == target.count) {
+      std::construct_at(d + i, std::forward<Args>(args)...);
+    } else {
+      T tmp(std::forward<Args>(args)...);
+      std::construct_at(d + target.count, std::move(d[target.count - 1]));
+      std::move_backward(d + i, d + target.count - 1, d + target.count);
+      d[i] = std::move(tmp);
+    }
+    resize_chunk(c, 1);
+    return d[i];
+  }
+
+  void insert(std::size_t pos, const T &value) { emplace(pos, value); }
+  void insert(std::size_t pos, T &&value) { emplace(pos, std::move(value)); }
+
+  /**
+   * @brief Remove the element at a position.
+   *
+   * @param pos The position of the element, less than size().
+   */
+  void erase(std::size_t pos) {
+    const auto [c, i] = locate(pos);
+    chunk &target = *chunks[c];
+    T *d = target.data();
+    std::move(d + i + 1, d + target.count, d + i);
+    std::destroy_at(d + target.count - 1);
+    resize_chunk(c, -1);
+
+    if (counts[c] == 0)
+      remove_chunk(c);
+    else if (c + 1 < chunks.size() &&
+             counts[c] + counts[c + 1] <= chunk_size / 2)
+      merge_next(c);
+  }
+
+  /**
+   * @brief Remove all elements and release the chunks.
+   */
+  void clear() {
+    for (chunk *c : chunks) {
+      std::destroy_n(c->data(), c->count);
+      delete c;
+    }
+    chunks.clear();
+    counts.clear();
+    tree.clear();
+    total = 0;
+  }
+
+private:
+  chunk *first_chunk() const { return chunks.empty() ? nullptr : chunks[0]; }
+
+  /**
+   * @brief Find the chunk and the index inside it of a position.
+   *
+   * Descends the Fenwick tree to the last chunk starting at or before pos;
+   * chunks are never empty, so that chunk holds pos.
+   */
+  std::pair<std::size_t, std::size_t> locate(std::size_t pos) const {
+    std::size_t c = 0;
+    for (std::size_t step = std::bit_floor(counts.size()); step; step >>= 1) {
+      if (c + step < tree.size() && tree[c + step] <= pos) {
+        c += step;
+        pos -= tree[c];
+      }
+    }
+    return {c, pos};
+  }
+
+  template <bool is_const>
+  basic_slice<is_const> make_slice(std::size_t start, std::size_t end) const {
+    end = std::min(end, total);
+    start = std::min(start, end);
+    const auto position = [this](std::size_t pos) {
+      if (pos == total)
+        return basic_iterator<is_const>();
+      const auto [c, i] = locate(pos);
+      return basic_iterator<is_const>(chunks[c], i);
+    };
+    return {position(start), position(end), end - start};
+  }
+
+  /**
+   * @brief Sum of the sizes of the first k chunks.
+   */
+  std::size_t prefix(std::size_t k) const noexcept {
+    std::size_t sum = 0;
+    for (; k; k &= k - 1)
+      sum += tree[k];
+    return sum;
+  }
+
+  /**
+   * @brief Add delta elements to the size of chunk c, in O(log n).
+   */
+  void resize_chunk(std::size_t c, std::ptrdiff_t delta) noexcept {
+    chunks[c]->count += delta;
+    counts[c] += delta;
+    total += delta;
+    for (std::size_t k = c + 1; k < tree.size(); k += k & (~k + 1))
+      tree[k] += delta;
+  }
+
+  /**
+   * @brief Rebuild the Fenwick tree from counts in O(number of chunks).
+   */
+  void rebuild_index() {
+    tree.assign(counts.size() + 1, 0);
+    for (std::size_t k = 1; k < tree.size(); k++) {
+      tree[k] += counts[k - 1];
+      const std::size_t parent = k + (k & (~k + 1));
+      if (parent < tree.size())
+        tree[parent] += tree[k];
+    }
+  }
+
+  /**
+   * @brief Insert an empty chunk before chunk c.
+   */
+  void add_chunk(std::size_t c) {
+    chunk *added = new chunk;
+    added->next = c < chunks.size() ? chunks[c] : nullptr;
+    if (c > 0)
+      chunks[c - 1]->next = added;
+    chunks.insert(chunks.begin() + c, added);
+    counts.insert(counts.begin() + c, 0);
+
+    if (c + 1 < chunks.size()) {
+      rebuild_index();
+    } else {
+      // Appending: the new node covers (k - lowbit(k), k], all already known.
+      if (tree.empty())
+        tree.push_back(0);
+      const std::size_t k = chunks.size();
+      tree.push_back(prefix(k - 1) - prefix(k - (k & (~k + 1))));
+    }
+  }
+
+  /**
+   * @brief Release the empty chunk c.
+   */
+  void remove_chunk(std::size_t c) {
+    if (c > 0)
+      chunks[c - 1]->next = chunks[c]->next;
+    delete chunks[c];
+    chunks.erase(chunks.begin() + c);
+    counts.erase(counts.begin() + c);
+
+    if (c < chunks.size())
+      rebuild_index();
+    else
+      tree.pop_back();
+  }
+
+  void split(std::size_t c) {
+    add_chunk(c + 1);
+    chunk &full = *chunks[c];
+    chunk &next = *chunks[c + 1];
+    const std::size_t keep = full.count / 2;
+    std::uninitialized_move(full.data() + keep, full.data() + full.count,
+                            next.data());
+    std::destroy(full.data() + keep, full.data() + full.count);
+    next.count = counts[c + 1] = full.count - keep;
+    full.count = counts[c] = keep;
+    rebuild_index();
+  }
+
+  void merge_next(std::size_t c) {
+    chunk &target = *chunks[c];
+    chunk &next = *chunks[c + 1];
+    std::uninitialized_move(next.data(), next.data() + next.count,
+                            target.data() + target.count);
+    std::destroy_n(next.data(), next.count);
+    // Through the index, as remove_chunk() only drops the last tree node.
+    const auto moved = static_cast<std::ptrdiff_t>(next.count);
+    resize_chunk(c, moved);
+    resize_chunk(c + 1, -moved);
+    remove_chunk(c + 1);
+  }
+
+  std::vector<chunk *> chunks;     ///< The chunks, in order.
+  std::vector<std::size_t> counts; ///< Size of each chunk, for the index.
+  std::vector<std::size_t> tree;   ///< Fenwick tree over counts, 1-based.
+  std::size_t total = 0;           ///< Number of elements.
+};
+
+/**
+ * @brief Get a slice of an unrolled_list.
+ *
+ * Unlike the std::list overload this does not walk the list or allocate: it
+ * returns a view over the chunks holding the range [start, end).
+ *
+ * @tparam T The type of elements in the list.
+ * @tparam chunk_size The chunk size of the list.
+ * @param l The list from which to extract the slice.
+ * @param start The starting index of the slice.
+ * @param end The ending index (exclusive) of the slice.
+ * @return A view over the elements in the specified range.
+ */
+template <typename T, std::size_t chunk_size>
+auto get_slice(unrolled_list<T, chunk_size> &l, std::size_t start,
+               std::size_t end) {
+  return l.slice(start, end);
+}
+
+#endif
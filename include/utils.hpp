@@ -1,15 +1,22 @@
 #ifndef EXSTD_UTILS_HPP
 #define EXSTD_UTILS_HPP
 
+#include <algorithm>
 #include <cmath>
 #include <cstdint>
 #include <cstring>
+#include <limits>
 #include <list>
 #include <ranges>
+#include <thread>
 #include <tuple>
 #include <type_traits>
 #include <vector>
 
+#if defined(__AVX512F__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
 /**
  * @file utils.hpp
  * @brief Contains the utility functions and operators for various purposes.
@@ -26,6 +33,8 @@
  * @param start The starting index of the slice.
  * @param end The ending index (exclusive) of the slice.
  * @return A vector containing the pointers to elements in the specified range.
+ * @see unrolled_list for a container that slices without walking or
+ * allocating.
  */
 template <typename T>
 std::vector<T *> get_slice(std::list<T> &l, size_t start, size_t end) {
@@ -57,13 +66,153 @@ auto error(const T &estimated, const T &actual)
   return std::abs(diff / actual);
 }
 
+namespace detail {
+
+/**
+ * @brief SIMD operations used by max_relative_error().
+ *
+ * Specialized for float and double when AVX-512 or AVX2 is enabled at compile
+ * time; a width of 0 selects the scalar loop.
+ */
+template <typename T> struct error_ops {
+  static constexpr std::size_t width = 0;
+};
+
+#if defined(__AVX512F__)
+// GCC 12's _mm512_max_ps/pd pass an intentionally undefined register as the
+// unused merge source, which -Wmaybe-uninitialized reports at every use.
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+template <> struct error_ops<float> {
+  using reg = __m512;
+  static constexpr std::size_t width = 16;
+  static reg load(const float *p) { return _mm512_loadu_ps(p); }
+  static reg set1(float v) { return _mm512_set1_ps(v); }
+  static reg relative(reg e, reg a) {
+    const reg rel = _mm512_abs_ps(_mm512_div_ps(_mm512_sub_ps(e, a), a));
+    const __mmask16 zero =
+        _mm512_cmp_ps_mask(a, _mm512_setzero_ps(), _CMP_EQ_OQ);
+    return _mm512_mask_blend_ps(zero, rel, e);
+  }
+  static reg max(reg x, reg acc) { return _mm512_max_ps(x, acc); }
+  static float reduce(reg acc) {
+    alignas(64) float lanes[width];
+    _mm512_store_ps(lanes, acc);
+    return *std::max_element(lanes, lanes + width);
+  }
+};
+
+template <> struct error_ops<double> {
+  using reg = __m512d;
+  static constexpr std::size_t width = 8;
+  static reg load(const double *p) { return _mm512_loadu_pd(p); }
+  static reg set1(double v) { return _mm512_set1_pd(v); }
+  static reg relative(reg e, reg a) {
+    const reg rel = _mm512_abs_pd(_mm512_div_pd(_mm512_sub_pd(e, a), a));
+    const __mmask8 zero =
+        _mm512_cmp_pd_mask(a, _mm512_setzero_pd(), _CMP_EQ_OQ);
+    return _mm512_mask_blend_pd(zero, rel, e);
+  }
+  static reg max(reg x, reg acc) { return _mm512_max_pd(x, acc); }
+  static double reduce(reg acc) {
+    alignas(64) double lanes[width];
+    _mm512_store_pd(lanes, acc);
+    return *std::max_element(lanes, lanes + width);
+  }
+};
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+#elif defined(__AVX2__)
+template <> struct error_ops<float> {
+  using reg = __m256;
+  static constexpr std::size_t width = 8;
+  static reg load(const float *p) { return _mm256_loadu_ps(p); }
+  static reg set1(float v) { return _mm256_set1_ps(v); }
+  static reg relative(reg e, reg a) {
+    const reg rel = _mm256_andnot_ps(
+        _mm256_set1_ps(-0.0f), _mm256_div_ps(_mm256_sub_ps(e, a), a));
+    const reg zero = _mm256_cmp_ps(a, _mm256_setzero_ps(), _CMP_EQ_OQ);
+    return _mm256_blendv_ps(rel, e, zero);
+  }
+  static reg max(reg x, reg acc) { return _mm256_max_ps(x, acc); }
+  static float reduce(reg acc) {
+    alignas(32) float lanes[width];
+    _mm256_store_ps(lanes, acc);
+    return *std::max_element(lanes, lanes + width);
+  }
+};
+
+template <> struct error_ops<double> {
+  using reg = __m256d;
+  static constexpr std::size_t width = 4;
+  static reg load(const double *p) { return _mm256_loadu_pd(p); }
+  static reg set1(double v) { return _mm256_set1_pd(v); }
+  static reg relative(reg e, reg a) {
+    const reg rel = _mm256_andnot_pd(
+        _mm256_set1_pd(-0.0), _mm256_div_pd(_mm256_sub_pd(e, a), a));
+    const reg zero = _mm256_cmp_pd(a, _mm256_setzero_pd(), _CMP_EQ_OQ);
+    return _mm256_blendv_pd(rel, e, zero);
+  }
+  static reg max(reg x, reg acc) { return _mm256_max_pd(x, acc); }
+  static double reduce(reg acc) {
+    alignas(32) double lanes[width];
+    _mm256_store_pd(lanes, acc);
+    return *std::max_element(lanes, lanes + width);
+  }
+};
+#endif
+
+/**
+ * @brief Maximum relative error over two arrays.
+ *
+ * Same result as folding std::max over error() for every element: the vector
+ * max keeps the accumulator when an element is NaN, like std::max does, and
+ * the max is exact so the order of the reduction does not matter.
+ *
+ * @param estimated The estimated values.
+ * @param actual The actual values.
+ * @param n The number of elements.
+ * @param max_error The initial maximum.
+ * @return The maximum relative error.
+ */
+template <typename T>
+T max_relative_error(const T *estimated, const T *actual, std::size_t n,
+                     T max_error) {
+  std::size_t i = 0;
+  if constexpr (error_ops<T>::width > 0) {
+    using ops = error_ops<T>;
+    if (n >= ops::width) {
+      auto acc = ops::set1(max_error);
+      for (; i + ops::width <= n; i += ops::width)
+        acc = ops::max(
+            ops::relative(ops::load(estimated + i), ops::load(actual + i)),
+            acc);
+      max_error = ops::reduce(acc);
+    }
+  }
+  for (; i < n; i++)
+    max_error = std::max(max_error, error(estimated[i], actual[i]));
+  return max_error;
+}
+
+template <typename Range>
+concept arithmetic_contiguous_range =
+    std::ranges::contiguous_range<const Range> &&
+    std::ranges::sized_range<const Range> &&
+    std::is_arithmetic_v<std::ranges::range_value_t<Range>>;
+
+} // namespace detail
+
 /**
  * @brief Calculate the maximum relative error between corresponding elements of
  * two ranges.
  *
  * This function calculates the maximum relative error between corresponding
  * elements of two ranges. It assumes that both ranges have the same type of
- * elements.
+ * elements. Contiguous ranges of arithmetic values use a vectorized kernel.
  *
  * @tparam Range the type of the ranges.
  * @param estimated The estimated range.
@@ -78,21 +227,85 @@ std::ranges::range_value_t<Range> error(const Range &estimated,
                                         const Range &actual) {
   std::ranges::range_value_t<Range> max_error =
       std::numeric_limits<std::ranges::range_value_t<Range>>::lowest();
-  auto est_it = std::begin(estimated);
-  auto act_it = std::begin(actual);
-  while (est_it != std::end(estimated) && act_it != std::end(actual)) {
-    max_error = std::max(max_error, error(*est_it, *act_it));
-    est_it = std::next(est_it);
-    act_it = std::next(act_it);
+  if constexpr (detail::arithmetic_contiguous_range<Range>) {
+    return detail::max_relative_error(
+        std::ranges::data(estimated), std::ranges::data(actual),
+        std::min<std::size_t>(std::ranges::size(estimated),
+                              std::ranges::size(actual)),
+        max_error);
+  } else {
+    auto est_it = std::begin(estimated);
+    auto act_it = std::begin(actual);
+    while (est_it != std::end(estimated) && act_it != std::end(actual)) {
+      max_error = std::max(max_error, error(*est_it, *act_it));
+      est_it = std::next(est_it);
+      act_it = std::next(act_it);
+    }
+
+    return max_error;
   }
+}
 
-  return max_error;
+/**
+ * @brief Calculate the maximum relative error between two ranges using
+ * several threads.
+ *
+ * Contiguous ranges of arithmetic values are split into chunks reduced in
+ * parallel; the result is the same as the single-threaded overload. Other
+ * ranges, and ranges too small to be worth splitting, are reduced on the
+ * calling thread.
+ *
+ * @tparam Range the type of the ranges.
+ * @param estimated The estimated range.
+ * @param actual The actual range.
+ * @param threads The maximum number of threads, 0 for one per hardware
+ * thread.
+ * @return The maximum relative error between corresponding elements of the
+ * ranges.
+ */
+template <std::ranges::range Range>
+  requires std::same_as<std::ranges::range_value_t<Range>,
+                        std::ranges::range_value_t<Range>>
+std::ranges::range_value_t<Range>
+error(const Range &estimated, const Range &actual, std::size_t threads) {
+  using T = std::ranges::range_value_t<Range>;
+  if constexpr (detail::arithmetic_contiguous_range<Range>) {
+    constexpr std::size_t min_chunk = std::size_t(1) << 16;
+    const std::size_t n = std::min<std::size_t>(std::ranges::size(estimated),
+                                                std::ranges::size(actual));
+    if (threads == 0)
+      threads = std::max(1u, std::thread::hardware_concurrency());
+    threads = std::min(threads, n / min_chunk);
+    if (threads > 1) {
+      const T *est = std::ranges::data(estimated);
+      const T *act = std::ranges::data(actual);
+      const std::size_t chunk = (n + threads - 1) / threads;
+      std::vector<T> partial(threads, std::numeric_limits<T>::lowest());
+      std::vector<std::thread> workers;
+      workers.reserve(threads - 1);
+      for (std::size_t t = 1; t < threads; t++) {
+        const std::size_t begin = t * chunk;
+        const std::size_t len = std::min(chunk, n - std::min(n, begin));
+        workers.emplace_back([&partial, est, act, begin, len, t] {
+          partial[t] = detail::max_relative_error(
+              est + begin, act + begin, len, partial[t]);
+        });
+      }
+      partial[0] = detail::max_relative_error(est, act, chunk, partial[0]);
+      for (auto &w : workers)
+        w.join();
+      return *std::max_element(partial.begin(), partial.end());
+    }
+  }
+  return error(estimated, actual);
 }
 
 /**
  * @brief Compare two ranges for equality
  *
  * This operator checks if two ranges are equal by comparing their elements.
+ * Contiguous ranges of scalars whose equality is bytewise (integers, enums,
+ * pointers) are compared with memcmp.
  *
  * @tparam Range The type of the ranges.
  * @param v1 The first range.
@@ -103,19 +316,31 @@ template <std::ranges::range Range>
   requires std::same_as<std::ranges::range_value_t<Range>,
                         std::ranges::range_value_t<Range>>
 bool operator==(const Range &v1, const Range &v2) {
-  auto v1_it = std::begin(v1);
-  auto v2_it = std::begin(v2);
-  if (std::distance(v1_it, std::end(v1)) != std::distance(v2_it, std::end(v2)))
-    return false;
-
-  while (v1_it != std::end(v1) && v2_it != std::end(v2)) {
-    if (*v1_it != *v2_it)
+  using T = std::ranges::range_value_t<Range>;
+  if constexpr (std::ranges::contiguous_range<const Range> &&
+                std::ranges::sized_range<const Range> &&
+                std::is_scalar_v<T> &&
+                std::has_unique_object_representations_v<T>) {
+    const std::size_t n = std::ranges::size(v1);
+    if (n != std::ranges::size(v2))
       return false;
-    v1_it = std::next(v1_it);
-    v2_it = std::next(v2_it);
-  }
+    return n == 0 || std::memcmp(std::ranges::data(v1), std::ranges::data(v2),
+                                 n * sizeof(T)) == 0;
+  } else {
+    auto v1_it = std::begin(v1);
+    auto v2_it = std::begin(v2);
+    if (std::ranges::distance(v1) != std::ranges::distance(v2))
+      return false;
+
+    while (v1_it != std::end(v1) && v2_it != std::end(v2)) {
+      if (*v1_it != *v2_it)
+        return false;
+      v1_it = std::next(v1_it);
+      v2_it = std::next(v2_it);
+    }
 
-  return true;
+    return true;
+  }
 }
 
 #endif
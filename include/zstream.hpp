@@ -8,8 +8,10 @@
 
 #include <cstddef>
 #include <cstring>
+#include <new>
 #include <iostream>
 #include <istream>
+#include <memory_resource>
 #include <ostream>
 #include <streambuf>
 #include <sys/types.h>
@@ -18,6 +20,20 @@
 #include <zconf.h>
 #include <zlib.h>
 
+#include "trace.hpp"
+
+#ifdef EXSTD_TRACE
+inline trace_counter zstream_deflate_in{"zstream.deflate.bytes_in"};
+inline trace_counter zstream_deflate_out{"zstream.deflate.bytes_out"};
+inline trace_counter zstream_inflate_in{"zstream.inflate.bytes_in"};
+inline trace_counter zstream_inflate_out{"zstream.inflate.bytes_out"};
+/// Compression ratio of each flush, in percent of the compressed size.
+inline trace_histogram zstream_deflate_ratio{"zstream.deflate.ratio_pct",
+                                             false};
+inline trace_histogram zstream_flush_time{"zstream.flush_buffer"};
+inline trace_histogram zstream_underflow_time{"zstream.underflow"};
+#endif
+
 /**
  * @brief A stream buffer for zlib compression and decompression.
  */
@@ -27,20 +43,28 @@ public:
    * @brief Constructor for compressing streams.
    * @param sink The output stream to write compressed data to.
    * @param buff_sz The size of the buffer to use.
+   * @param resource The memory resource for the buffers and the zlib state.
    */
-  explicit zstream_buffer(std::ostream *sink, std::size_t buff_sz = 1024)
-      : sink_stream(sink), is_compressing(true), buffer(buff_sz) {
-    init_z_stream();
+  explicit zstream_buffer(
+      std::ostream *sink, std::size_t buff_sz = 1024,
+      std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+      : sink_stream(sink), is_compressing(true), buffer(buff_sz, resource),
+        out_buffer(buff_sz * 2, resource) {
+    init_z_stream(resource);
   }
 
   /**
    * @brief Constructor for decompressing streams.
    * @param source The input stream to read compressed data from.
    * @param buff_sz The size of the buffer to use.
+   * @param resource The memory resource for the buffers and the zlib state.
    */
-  explicit zstream_buffer(std::istream *source, std::size_t buff_sz = 1024)
-      : source_stream(source), is_compressing(false), buffer(buff_sz) {
-    init_z_stream();
+  explicit zstream_buffer(
+      std::istream *source, std::size_t buff_sz = 1024,
+      std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+      : source_stream(source), is_compressing(false),
+        buffer(buff_sz, resource), out_buffer(buff_sz * 2, resource) {
+    init_z_stream(resource);
   }
 
   /**
@@ -59,6 +83,7 @@ protected:
    * @return The next available character from the decompressed stream.
    */
   int_type underflow() override {
+    EXSTD_TRACE_SCOPE("zstream.underflow", zstream_underflow_time);
     if (!source_stream || source_stream->eof())
       return traits_type::eof();
 
@@ -67,11 +92,12 @@ protected:
 
     if (read_bytes <= 0)
       return traits_type::eof();
+    EXSTD_TRACE_ADD(zstream_inflate_in, read_bytes);
 
     z_stream_def.avail_in = static_cast<uInt>(read_bytes);
     z_stream_def.next_in = reinterpret_cast<Bytef *>(buffer.data());
 
-    std::vector<char> out_buffer(buffer.size() * 2);
+    // out_buffer is kept between calls and only ever grows.
     z_stream_def.avail_out = static_cast<uInt>(out_buffer.size());
     z_stream_def.next_out = reinterpret_cast<Bytef *>(out_buffer.data());
 
@@ -99,9 +125,9 @@ protected:
       }
     }
 
-    buffer = std::move(out_buffer);
-    setg(buffer.data(), buffer.data(),
-         buffer.data() + (buffer.size() - z_stream_def.avail_out));
+    setg(out_buffer.data(), out_buffer.data(),
+         out_buffer.data() + (out_buffer.size() - z_stream_def.avail_out));
+    EXSTD_TRACE_ADD(zstream_inflate_out, egptr() - eback());
 
     return traits_type::to_int_type(*gptr());
   }
@@ -134,14 +160,44 @@ protected:
   int sync() override { return flush_buffer() ? 0 : -1; }
 
 private:
+  /**
+   * @brief zlib allocation callback forwarding to a memory resource.
+   *
+   * zfree does not get the size back, so it is stored in front of the block.
+   */
+  static voidpf z_alloc(voidpf opaque, uInt items, uInt size) {
+    auto *resource = static_cast<std::pmr::memory_resource *>(opaque);
+    const std::size_t bytes =
+        sizeof(std::max_align_t) + std::size_t(items) * size;
+    try {
+      auto *block = static_cast<std::byte *>(
+          resource->allocate(bytes, alignof(std::max_align_t)));
+      *reinterpret_cast<std::size_t *>(block) = bytes;
+      return block + sizeof(std::max_align_t);
+    } catch (const std::bad_alloc &) {
+      return Z_NULL;
+    }
+  }
+
+  /**
+   * @brief zlib deallocation callback matching z_alloc().
+   */
+  static void z_free(voidpf opaque, voidpf address) {
+    auto *resource = static_cast<std::pmr::memory_resource *>(opaque);
+    auto *block = static_cast<std::byte *>(address) - sizeof(std::max_align_t);
+    resource->deallocate(block, *reinterpret_cast<std::size_t *>(block),
+                         alignof(std::max_align_t));
+  }
+
   /**
    * @brief Initializes the zlib stream.
+   * @param resource The memory resource zlib allocates its state from.
    */
-  void init_z_stream() {
+  void init_z_stream(std::pmr::memory_resource *resource) {
     memset(&z_stream_def, 0, sizeof(z_stream));
-    z_stream_def.zalloc = Z_NULL;
-    z_stream_def.zfree = Z_NULL;
-    z_stream_def.opaque = Z_NULL;
+    z_stream_def.zalloc = z_alloc;
+    z_stream_def.zfree = z_free;
+    z_stream_def.opaque = resource;
     if (is_compressing) {
       deflateInit(&z_stream_def, Z_BEST_COMPRESSION);
       setp(buffer.data(), buffer.data() + buffer.size() - 1);
@@ -157,28 +213,39 @@ private:
    * @return True on success, false on failure.
    */
   bool flush_buffer() {
+    EXSTD_TRACE_SCOPE("zstream.flush_buffer", zstream_flush_time);
     // Prepare the input for compression
-    z_stream_def.avail_in = static_cast<uInt>(pptr() - pbase());
+    const std::size_t read_size = pptr() - pbase();
+    z_stream_def.avail_in = static_cast<uInt>(read_size);
     z_stream_def.next_in = reinterpret_cast<Bytef *>(buffer.data());
 
-    // Dynamically resize the output buffer if necessary
-    std::vector<char> out_buffer(buffer.size() * 2); // Increase the buffer size
-
+    // out_buffer is kept between calls and grown when deflate fills it.
+    std::size_t written = 0;
     do {
-      z_stream_def.avail_out = static_cast<uInt>(out_buffer.size());
-      z_stream_def.next_out = reinterpret_cast<Bytef *>(out_buffer.data());
+      if (written == out_buffer.size())
+        out_buffer.resize(out_buffer.size() * 2);
+      z_stream_def.avail_out = static_cast<uInt>(out_buffer.size() - written);
+      z_stream_def.next_out =
+          reinterpret_cast<Bytef *>(out_buffer.data() + written);
 
       // Compress the data
       int ret = deflate(&z_stream_def, Z_SYNC_FLUSH);
       if (ret != Z_OK) {
         return false; // Handle compression error
       }
+      written = out_buffer.size() - z_stream_def.avail_out;
     } while (z_stream_def.avail_out ==
              0); // Repeat if output buffer was too small
 
     // Write compressed data to sink stream
-    std::streamsize write_size = out_buffer.size() - z_stream_def.avail_out;
-    sink_stream->write(out_buffer.data(), write_size);
+    sink_stream->write(out_buffer.data(), written);
+    // Empty syncs (e.g. flush() from the destructor) compress nothing and
+    // would only skew the ratio.
+    if (read_size > 0) {
+      EXSTD_TRACE_ADD(zstream_deflate_in, read_size);
+      EXSTD_TRACE_ADD(zstream_deflate_out, written);
+      EXSTD_TRACE_RECORD(zstream_deflate_ratio, read_size * 100 / written);
+    }
 
     // Reset the buffer pointers
     setp(buffer.data(), buffer.data() + buffer.size() - 1);
@@ -195,8 +262,9 @@ private:
 
   bool is_compressing; ///< Flag indicating whether the buffer is compressing or
                        ///< decompressing.
-  std::vector<char> buffer; ///< The buffer for holding data.
-  z_stream z_stream_def;    ///< The zlib stream structure.
+  std::pmr::vector<char> buffer;     ///< The buffer for holding data.
+  std::pmr::vector<char> out_buffer; ///< The (de)compressed data.
+  z_stream z_stream_def;             ///< The zlib stream structure.
 };
 
 /**
@@ -207,16 +275,22 @@ public:
   /**
    * @brief Constructor for compressing streams.
    * @param sink The output stream to write compressed data to.
+   * @param resource The memory resource for the buffers and the zlib state.
    */
-  zstream(std::ostream *sink) : std::iostream(&buffer), buffer(sink) {
+  zstream(std::ostream *sink, std::pmr::memory_resource *resource =
+                            std::pmr::get_default_resource())
+      : std::iostream(&buffer), buffer(sink, 1024, resource) {
     init(&buffer);
   }
 
   /**
    * @brief Constructor for decompressing streams.
    * @param source The input stream to read compressed data from.
+   * @param resource The memory resource for the buffers and the zlib state.
    */
-  zstream(std::istream *source) : std::iostream(&buffer), buffer(source) {
+  zstream(std::istream *source, std::pmr::memory_resource *resource =
+                            std::pmr::get_default_resource())
+      : std::iostream(&buffer), buffer(source, 1024, resource) {
     init(&buffer);
   }
 